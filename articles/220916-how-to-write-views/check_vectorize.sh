@@ -0,0 +1,57 @@
+#!/usr/bin/env bash
+# enumerate_view.cpp の計測用ループが自動ベクトル化されることを、コンパイラの最適化レポートで確かめる
+# 実行時間の比は計測のたびに揺れるため、ベクトル化されたかどうかはこちらで判定する
+#
+#   ./check_vectorize.sh [ソースファイル]
+#
+# 環境変数
+#   CXX  使用するコンパイラ (既定: g++。clang++ も可)
+#
+# indexed_loop と contiguous_enumerate_loop のループがベクトル化されなければ失敗する
+# generic_enumerate_loop は結果を表示するのみ (GCC 12 では一般の enumerate_view のループもベクトル化される)
+set -euo pipefail
+
+here=$(cd "$(dirname "$0")" && pwd)
+src=${1:-$here/enumerate_view.cpp}
+cxx=${CXX:-g++}
+
+case $cxx in
+*clang*)
+  report=(-Rpass=loop-vectorize)
+  pattern='remark: vectorized loop'
+  ;;
+*)
+  report=(-fopt-info-vec-optimized)
+  pattern='optimized: loop vectorized'
+  ;;
+esac
+
+log=$("$cxx" -std=c++2b -O3 "${report[@]}" -c "$src" -o /dev/null 2>&1) || {
+  echo "$log" >&2
+  echo "$cxx failed to compile $src" >&2
+  exit 1
+}
+
+# 関数 $1 の本体にある最初の for 文の行番号
+loop_line() {
+  awk -v fn="$1" '
+    $0 ~ "^void " fn "\\(" { inside = 1 }
+    inside && /^[[:space:]]*for \(/ { print NR; exit }
+  ' "$src"
+}
+
+status=0
+for fn in indexed_loop contiguous_enumerate_loop generic_enumerate_loop; do
+  line=$(loop_line "$fn")
+  if [[ -z $line ]]; then
+    echo "$fn: loop not found in $src" >&2
+    exit 1
+  fi
+  if grep -qF -- "$src:$line:" <<<"$(grep -- "$pattern" <<<"$log")"; then
+    echo "$fn ($src:$line): vectorized"
+  else
+    echo "$fn ($src:$line): NOT vectorized"
+    [[ $fn == generic_enumerate_loop ]] || status=1
+  fi
+done
+exit $status
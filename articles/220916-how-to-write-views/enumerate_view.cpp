@@ -0,0 +1,652 @@
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// for main
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace ns {
+  template <class View>
+  struct deduce_iterator_category {};
+
+  template <class View>
+  requires requires {
+    typename std::iterator_traits<
+      std::ranges::iterator_t<View>>::iterator_category;
+  }
+  struct deduce_iterator_category<View> {
+    // 間接参照演算子が左辺値参照を返さないため Cpp17InputIterator 止まり
+    using iterator_category = std::input_iterator_tag;
+  };
+
+  /// 220916-how-to-write-views.md で作成した enumerate_view
+  /// @tparam View 元となる view の型
+  template <std::ranges::input_range View>
+  requires std::ranges::view<View>
+  struct enumerate_view : std::ranges::view_interface<enumerate_view<View>> {
+  private:
+    //! 元となる view
+    View base_ = View();
+
+    template <bool Const>
+    struct iterator;
+    template <bool Const>
+    struct sentinel;
+
+  public:
+    enumerate_view() requires std::default_initializable<View> = default;
+    constexpr enumerate_view(View base) : base_(std::move(base)) {}
+
+    constexpr iterator<false> begin() { return {std::ranges::begin(base_), 0}; }
+    constexpr iterator<true>
+    begin() const requires std::ranges::input_range<const View> {
+      return {std::ranges::begin(base_), 0};
+    }
+
+    constexpr auto end() {
+      if constexpr (std::ranges::common_range<View> and //
+                    std::ranges::sized_range<View>)
+        return iterator<false>(std::ranges::end(base_),
+                               std::ranges::size(base_));
+      else
+        return sentinel<false>(std::ranges::end(base_));
+    }
+    constexpr auto end() const requires std::ranges::input_range<const View> {
+      if constexpr (std::ranges::common_range<const View> and //
+                    std::ranges::sized_range<const View>)
+        return iterator<true>(std::ranges::end(base_), std::ranges::size(base_));
+      else
+        return sentinel<true>(std::ranges::end(base_));
+    }
+
+    constexpr auto size() requires std::ranges::sized_range<View> {
+      return std::ranges::size(base_);
+    }
+    constexpr auto size() const requires std::ranges::sized_range<const View> {
+      return std::ranges::size(base_);
+    }
+  };
+
+  template <class Range>
+  enumerate_view(Range&&) -> enumerate_view<std::views::all_t<Range>>;
+
+  template <std::ranges::input_range View>
+  requires std::ranges::view<View>
+  template <bool Const>
+  struct enumerate_view<View>::iterator : deduce_iterator_category<
+                                            std::conditional_t<Const, const View, View>> {
+  private:
+    using Base = std::conditional_t<Const, const View, View>;
+    //! 元となるイテレータの現在位置
+    std::ranges::iterator_t<Base> current_ = std::ranges::iterator_t<Base>();
+    //! 現在のインデックス
+    std::size_t count_ = 0;
+
+  public:
+    using difference_type = std::ranges::range_difference_t<Base>;
+    using value_type = std::pair<std::size_t, std::ranges::range_value_t<Base>>;
+    using iterator_concept =
+      std::conditional_t<std::ranges::random_access_range<Base>, std::random_access_iterator_tag,
+      std::conditional_t<std::ranges::bidirectional_range<Base>, std::bidirectional_iterator_tag,
+      std::conditional_t<std::ranges::forward_range<Base>,       std::forward_iterator_tag,
+      /* else */                                                 std::input_iterator_tag>>>;
+
+    iterator() requires
+      std::default_initializable<std::ranges::iterator_t<Base>> = default;
+    constexpr iterator(std::ranges::iterator_t<Base> current, std::size_t count)
+      : current_(std::move(current)), count_(std::move(count)) {}
+
+    constexpr const std::ranges::iterator_t<Base>& base() const& noexcept {
+      return current_;
+    }
+    constexpr std::ranges::iterator_t<Base> base() && {
+      return std::move(current_);
+    }
+
+    constexpr std::pair<std::size_t, std::ranges::range_reference_t<Base>>
+    operator*() const {
+      return {count_, *current_};
+    }
+
+    constexpr iterator& operator++() {
+      ++current_;
+      ++count_;
+      return *this;
+    }
+    constexpr void operator++(int) { ++*this; }
+    constexpr iterator
+    operator++(int) requires std::ranges::forward_range<Base> {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    constexpr iterator&
+    operator--() requires std::ranges::bidirectional_range<Base> {
+      --current_;
+      --count_;
+      return *this;
+    }
+    constexpr iterator
+    operator--(int) requires std::ranges::bidirectional_range<Base> {
+      auto tmp = *this;
+      --*this;
+      return tmp;
+    }
+
+    constexpr iterator& operator+=(difference_type n) //
+      requires std::ranges::random_access_range<Base> {
+      current_ += n;
+      count_ += n;
+      return *this;
+    }
+    constexpr iterator& operator-=(difference_type n) //
+      requires std::ranges::random_access_range<Base> {
+      return *this += -n;
+    }
+    friend constexpr iterator operator+(iterator x, difference_type n) //
+      requires std::ranges::random_access_range<Base> {
+      x += n;
+      return x;
+    }
+    friend constexpr iterator operator+(difference_type n, iterator x) //
+      requires std::ranges::random_access_range<Base> {
+      x += n;
+      return x;
+    }
+    friend constexpr iterator operator-(iterator x, difference_type n) //
+      requires std::ranges::random_access_range<Base> {
+      x -= n;
+      return x;
+    }
+    friend constexpr difference_type //
+    operator-(const iterator& x, const iterator& y) requires
+      std::ranges::random_access_range<Base> {
+      return x.current_ - y.current_;
+    }
+
+    constexpr std::pair<std::size_t, std::ranges::range_reference_t<Base>>
+    operator[](difference_type n) const //
+      requires std::ranges::random_access_range<Base> {
+      return *(*this + n);
+    }
+
+    friend constexpr bool operator==(const iterator& x, const iterator& y) //
+      requires std::equality_comparable<std::ranges::iterator_t<Base>> {
+      return x.current_ == y.current_;
+    }
+    friend constexpr bool operator<(const iterator& x, const iterator& y) //
+      requires std::ranges::random_access_range<Base> {
+      return x.current_ < y.current_;
+    }
+    friend constexpr bool operator>(const iterator& x, const iterator& y) //
+      requires std::ranges::random_access_range<Base> {
+      return y < x;
+    }
+    friend constexpr bool operator<=(const iterator& x, const iterator& y) //
+      requires std::ranges::random_access_range<Base> {
+      return not(y < x);
+    }
+    friend constexpr bool operator>=(const iterator& x, const iterator& y) //
+      requires std::ranges::random_access_range<Base> {
+      return not(x < y);
+    }
+    friend constexpr auto operator<=>(const iterator& x, const iterator& y) //
+      requires std::ranges::random_access_range<Base> and                   //
+      std::three_way_comparable<std::ranges::iterator_t<Base>> {
+      return x.current_ <=> y.current_;
+    }
+
+    friend constexpr std::pair<std::size_t,
+                               std::ranges::range_rvalue_reference_t<Base>>
+    iter_move(const iterator& x) noexcept(
+      noexcept(std::ranges::iter_move(x.current_))) {
+      return {x.count_, std::ranges::iter_move(x.current_)};
+    }
+  };
+
+  template <std::ranges::input_range View>
+  requires std::ranges::view<View>
+  template <bool Const>
+  struct enumerate_view<View>::sentinel {
+  private:
+    using Base = std::conditional_t<Const, const View, View>;
+    //! 元となる view の番兵イテレータ
+    std::ranges::sentinel_t<Base> end_ = std::ranges::sentinel_t<Base>();
+
+  public:
+    sentinel() = default;
+    constexpr explicit sentinel(std::ranges::sentinel_t<Base> end)
+      : end_(std::move(end)) {}
+
+    friend constexpr bool
+    operator==(const iterator<Const>& x, const sentinel& y) requires
+      std::sentinel_for<std::ranges::sentinel_t<Base>,
+                        std::ranges::iterator_t<Base>> {
+      return x.base() == y.end_;
+    }
+
+    friend constexpr std::ranges::range_difference_t<Base> //
+    operator-(const iterator<Const>& x, const sentinel& y) requires
+      std::sized_sentinel_for<std::ranges::sentinel_t<Base>,
+                              std::ranges::iterator_t<Base>> {
+      return x.base() - y.end_;
+    }
+    friend constexpr std::ranges::range_difference_t<Base>
+    operator-(const sentinel& x, const iterator<Const>& y) requires
+      std::sized_sentinel_for<std::ranges::sentinel_t<Base>,
+                              std::ranges::iterator_t<Base>> {
+      return x.end_ - y.base();
+    }
+  };
+
+  /// contiguous_range に対する enumerate_view の間接参照の結果
+  /// std::pair<std::size_t, T&> と異なりトリビアルにコピー可能であり、
+  /// 構造化束縛と first, second によるアクセスは std::pair と同様に行える
+  /// @tparam R 要素への参照型 (T& または T&&)
+  template <class R>
+  struct enumerate_reference {
+    std::size_t first;
+    R second;
+
+    constexpr enumerate_reference(std::size_t index, R value) noexcept
+      : first(index), second(static_cast<R>(value)) {}
+    // iter_move の結果から参照への変換 (common_reference のために必要)
+    template <class S>
+    requires std::convertible_to<S&, R>
+    constexpr enumerate_reference(const enumerate_reference<S>& x) noexcept
+      : first(x.first), second(x.second) {}
+
+    template <class U>
+    requires std::constructible_from<U, R>
+    constexpr operator std::pair<std::size_t, U>() const {
+      return {first, static_cast<R>(second)};
+    }
+  };
+
+  /// 元の view が contiguous_range の場合の enumerate_view
+  /// イテレータを先頭へのポインタと 1 つのインデックスのみで表す。
+  /// 元のイテレータとインデックスを別々に進める一般の場合と異なり、
+  /// ループ変数がインデックス 1 つになるため、手書きの添字ループと同様に自動ベクトル化される
+  template <std::ranges::input_range View>
+  requires std::ranges::view<View> and std::ranges::contiguous_range<View> and
+    std::ranges::sized_range<View>
+  struct enumerate_view<View>
+    : std::ranges::view_interface<enumerate_view<View>> {
+  private:
+    //! 元となる view
+    View base_ = View();
+
+    template <bool Const>
+    struct iterator;
+
+  public:
+    enumerate_view() requires std::default_initializable<View> = default;
+    constexpr enumerate_view(View base) : base_(std::move(base)) {}
+
+    constexpr iterator<false> begin() { return {data(), 0}; }
+    constexpr iterator<true>
+    begin() const requires std::ranges::contiguous_range<const View> {
+      return {data(), 0};
+    }
+
+    constexpr iterator<false> end() { return {data(), size()}; }
+    constexpr iterator<true>
+    end() const requires std::ranges::contiguous_range<const View> {
+      return {data(), size()};
+    }
+
+    /// アルゴリズムが enumerate_view を剥がして元の配列を直接扱えるよう、
+    /// 先頭へのポインタと要素数を公開する
+    constexpr auto data() { return std::ranges::data(base_); }
+    constexpr auto data() const
+      requires std::ranges::contiguous_range<const View> {
+      return std::ranges::data(base_);
+    }
+
+    constexpr std::size_t size() { return std::ranges::size(base_); }
+    constexpr std::size_t size() const
+      requires std::ranges::sized_range<const View> {
+      return std::ranges::size(base_);
+    }
+  };
+
+  template <std::ranges::input_range View>
+  requires std::ranges::view<View> and std::ranges::contiguous_range<View> and
+    std::ranges::sized_range<View>
+  template <bool Const>
+  struct enumerate_view<View>::iterator {
+  private:
+    using Base = std::conditional_t<Const, const View, View>;
+    using element_type =
+      std::remove_reference_t<std::ranges::range_reference_t<Base>>;
+    //! 元となる view の先頭
+    element_type* data_ = nullptr;
+    //! 現在のインデックス
+    std::size_t count_ = 0;
+
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::pair<std::size_t, std::remove_cv_t<element_type>>;
+    using reference = enumerate_reference<element_type&>;
+    using iterator_concept = std::random_access_iterator_tag;
+    // 間接参照演算子が左辺値参照を返さないため Cpp17InputIterator 止まり
+    using iterator_category = std::input_iterator_tag;
+
+    iterator() = default;
+    constexpr iterator(element_type* data, std::size_t count) noexcept
+      : data_(data), count_(count) {}
+
+    constexpr element_type* base() const noexcept { return data_ + count_; }
+
+    constexpr reference operator*() const noexcept {
+      return {count_, data_[count_]};
+    }
+    constexpr reference operator[](difference_type n) const noexcept {
+      return {count_ + n, data_[count_ + n]};
+    }
+
+    constexpr iterator& operator++() noexcept {
+      ++count_;
+      return *this;
+    }
+    constexpr iterator operator++(int) noexcept {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    constexpr iterator& operator--() noexcept {
+      --count_;
+      return *this;
+    }
+    constexpr iterator operator--(int) noexcept {
+      auto tmp = *this;
+      --*this;
+      return tmp;
+    }
+
+    constexpr iterator& operator+=(difference_type n) noexcept {
+      count_ += n;
+      return *this;
+    }
+    constexpr iterator& operator-=(difference_type n) noexcept {
+      return *this += -n;
+    }
+    friend constexpr iterator operator+(iterator x, difference_type n) noexcept {
+      x += n;
+      return x;
+    }
+    friend constexpr iterator operator+(difference_type n, iterator x) noexcept {
+      x += n;
+      return x;
+    }
+    friend constexpr iterator operator-(iterator x, difference_type n) noexcept {
+      x -= n;
+      return x;
+    }
+    friend constexpr difference_type operator-(const iterator& x,
+                                               const iterator& y) noexcept {
+      return static_cast<difference_type>(x.count_ - y.count_);
+    }
+
+    // 同じ view のイテレータ同士のみを比較するため、インデックスのみを比べる
+    friend constexpr bool operator==(const iterator& x,
+                                     const iterator& y) noexcept {
+      return x.count_ == y.count_;
+    }
+    friend constexpr auto operator<=>(const iterator& x,
+                                      const iterator& y) noexcept {
+      return x.count_ <=> y.count_;
+    }
+
+    friend constexpr enumerate_reference<element_type&&>
+    iter_move(const iterator& x) noexcept {
+      return {x.count_, std::move(x.data_[x.count_])};
+    }
+  };
+
+  struct enumerate_fn : std::ranges::range_adaptor_closure<enumerate_fn> {
+    template <std::ranges::viewable_range Range>
+    constexpr auto operator()(Range&& range) const
+      noexcept(noexcept(enumerate_view(std::forward<Range>(range)))) {
+      return enumerate_view(std::forward<Range>(range));
+    }
+  };
+
+  // enumerate_view を、連続する重ならない部分 [begin + i, begin + j) に分割する
+  // 各部分は元の enumerate_view のイテレータの組であるため、部分の先頭の
+  // インデックスは i から始まる
+  //
+  // 分割した部分は std::vector に格納して返す。enumerate_view のイテレータは
+  // 間接参照が左辺値参照を返さず Cpp17ForwardIterator を満たさないため、
+  // std::for_each(std::execution::par, ...) に直接渡すと逐次実行になる。
+  // 部分の列は Cpp17RandomAccessIterator を持つので、そのまま並列アルゴリズムに渡せる
+  struct par_enumerate_fn {
+    // 部分のイテレータは元の range のイテレータのみを持つため、
+    // 元の range が部分より長く生存することを borrowed_range で要求する
+    template <std::ranges::viewable_range Range>
+    requires std::ranges::borrowed_range<Range> and
+      std::ranges::random_access_range<Range> and std::ranges::sized_range<Range>
+    auto operator()(Range&& range, std::size_t grain) const {
+      assert(grain > 0);
+      enumerate_view e(std::forward<Range>(range));
+      using chunk = std::ranges::subrange<std::ranges::iterator_t<decltype(e)>>;
+      const auto first = e.begin();
+      const auto n = static_cast<std::ptrdiff_t>(e.size());
+      // 大きさが grain 以下となる最小の分割数で、ほぼ均等に分割する
+      const auto nchunks = std::max<std::ptrdiff_t>(
+        (n + static_cast<std::ptrdiff_t>(grain) - 1) / static_cast<std::ptrdiff_t>(grain), 1);
+      auto bound = [&](std::ptrdiff_t i) { return first + n * i / nchunks; };
+      std::vector<chunk> chunks;
+      chunks.reserve(nchunks);
+      for (std::ptrdiff_t i = 0; i < nchunks; ++i)
+        chunks.emplace_back(bound(i), bound(i + 1));
+      return chunks;
+    }
+  };
+
+  // 部分の列をワーカースレッドに割り当て、各部分に f を適用する
+  // 各スレッドは次に処理する部分の番号を共有のカウンタから取得するため、
+  // 部分ごとの処理時間に偏りがあっても負荷が均される
+  struct for_each_chunk_fn {
+    template <std::ranges::random_access_range Chunks, class F>
+    requires std::ranges::sized_range<Chunks> and
+      std::invocable<F&, std::ranges::range_reference_t<Chunks>>
+    void operator()(Chunks&& chunks, F f) const {
+      const auto n = std::ranges::size(chunks);
+      const auto nthreads = std::clamp<std::size_t>(
+        std::thread::hardware_concurrency(), 1, std::max<std::size_t>(n, 1));
+      std::atomic<std::size_t> next = 0;
+      std::vector<std::exception_ptr> errors(nthreads);
+      {
+        std::vector<std::jthread> workers;
+        workers.reserve(nthreads - 1);
+        auto work = [&](std::size_t t) {
+          try {
+            for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;)
+              std::invoke(f, std::ranges::begin(chunks)[i]);
+          } catch (...) {
+            errors[t] = std::current_exception();
+            // 残りの部分は処理しない
+            next.store(n, std::memory_order_relaxed);
+          }
+        };
+        for (std::size_t t = 1; t < nthreads; ++t)
+          workers.emplace_back(work, t);
+        work(0);
+      } // join
+      for (auto& e : errors)
+        if (e)
+          std::rethrow_exception(e);
+    }
+  };
+
+  inline namespace cpo {
+    inline constexpr auto enumerate = enumerate_fn();
+    inline constexpr auto par_enumerate = par_enumerate_fn();
+    inline constexpr auto for_each_chunk = for_each_chunk_fn();
+  } // namespace cpo
+} // namespace ns
+
+// 計測に用いるループ
+// main に展開されると、GCC は main を 1 度しか実行されない関数とみなしてループを自動ベクトル化しないため、
+// 関数ポインタを介して呼び出す
+void indexed_loop(std::span<std::uint32_t> w) {
+  for (std::size_t i = 0; i < w.size(); ++i)
+    w[i] += static_cast<std::uint32_t>(i);
+}
+
+void contiguous_enumerate_loop(std::span<std::uint32_t> w) {
+  for (auto [i, x] : w | ns::enumerate)
+    x += static_cast<std::uint32_t>(i);
+}
+
+void generic_enumerate_loop(std::span<std::uint32_t> w) {
+  // transform_view を挟んで contiguous_range でなくする
+  auto r = w | std::views::transform([](std::uint32_t& x) -> std::uint32_t& { return x; });
+  for (auto [i, x] : r | ns::enumerate)
+    x += static_cast<std::uint32_t>(i);
+}
+
+int main() {
+  {
+    std::vector<char> v{'a', 'b', 'c', 'd', 'e'};
+    static_assert(std::ranges::random_access_range<decltype(ns::enumerate_view(v))>);
+    static_assert(std::ranges::common_range<decltype(ns::enumerate_view(v))>);
+    for (auto&& [index, value] : v | ns::enumerate)
+      std::cout << index << ':' << value << ','; // output: 0:a,1:b,2:c,3:d,4:e,
+    std::cout << std::endl;
+
+    // 部分の先頭のインデックスは元の範囲における位置になる
+    auto chunks = ns::par_enumerate(v, 2);
+    assert(chunks.size() == 3);
+    std::size_t expected = 0;
+    for (auto chunk : chunks)
+      for (auto [index, value] : chunk) {
+        assert(index == expected && value == v[expected]);
+        ++expected;
+      }
+    assert(expected == v.size());
+    // 空の範囲は空の部分 1 つになる
+    std::vector<char> empty;
+    assert(ns::par_enumerate(empty, 4).size() == 1 && ns::par_enumerate(empty, 4)[0].empty());
+  }
+
+  // 添字を使って各要素を書き換える
+  constexpr std::size_t n = 1 << 24;
+  constexpr std::size_t grain = 1 << 16;
+  auto kernel = [](std::size_t i) { return std::sin(static_cast<double>(i)) * std::sqrt(static_cast<double>(i)); };
+  std::vector<double> expected(n), v1(n), v2(n), v3(n);
+
+  using clock = std::chrono::steady_clock;
+  auto t0 = clock::now();
+  for (auto [i, x] : expected | ns::enumerate)
+    x = kernel(i);
+  auto t1 = clock::now();
+  ns::for_each_chunk(ns::par_enumerate(v1, grain), [&](auto chunk) {
+    for (auto [i, x] : chunk)
+      x = kernel(i);
+  });
+  auto t2 = clock::now();
+  const auto chunks = ns::par_enumerate(v2, grain);
+  std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](auto chunk) {
+    for (auto [i, x] : chunk)
+      x = kernel(i);
+  });
+  auto t3 = clock::now();
+  // 要素ごとの並列実行: Cpp17InputIterator のため逐次実行にフォールバックする
+  auto e3 = v3 | ns::enumerate;
+  std::for_each(std::execution::par, e3.begin(), e3.end(), [&](auto p) { p.second = kernel(p.first); });
+  auto t4 = clock::now();
+  assert(v1 == expected && v2 == expected && v3 == expected);
+
+  // 例外はスレッドを跨いで呼び出し元に再送出される
+  bool thrown = false;
+  try {
+    ns::for_each_chunk(ns::par_enumerate(v1, grain), [](auto chunk) {
+      if ((*chunk.begin()).first != 0)
+        throw std::runtime_error("chunk");
+    });
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  assert(thrown);
+
+  using ms = std::chrono::duration<double, std::milli>;
+  std::cout << "threads: " << std::thread::hardware_concurrency()
+            << "\nsequential:                 " << ms(t1 - t0).count()
+            << " ms\nfor_each_chunk:             " << ms(t2 - t1).count()
+            << " ms\nstd::for_each(par, chunks): " << ms(t3 - t2).count()
+            << " ms\nstd::for_each(par, elems):  " << ms(t4 - t3).count() << " ms"
+            << std::endl;
+
+  // contiguous_range に対する特殊化
+  {
+    std::vector<std::string> ss{"a", "b"};
+    using E = decltype(ns::enumerate_view(ss));
+    static_assert(std::ranges::random_access_range<E> && std::ranges::sized_range<E>);
+    static_assert(std::ranges::random_access_range<const E>);
+    static_assert(std::is_trivially_copyable_v<std::ranges::range_reference_t<E>>);
+    static_assert(std::is_trivially_copyable_v<std::ranges::iterator_t<E>>);
+    static_assert(sizeof(std::ranges::iterator_t<E>) == 2 * sizeof(void*));
+    // 一般の場合の enumerate_view は従来どおり
+    static_assert(not std::is_trivially_copyable_v<std::ranges::range_reference_t<
+                    decltype(ns::enumerate_view(std::views::iota(0, 1)))>>);
+
+    auto e = ss | ns::enumerate;
+    assert(e.data() == ss.data() && e.size() == 2);
+    for (auto [index, value] : e)
+      value += std::to_string(index);
+    assert(ss[0] == "a0" && ss[1] == "b1");
+    std::vector<std::pair<std::size_t, std::string>> moved(2);
+    std::ranges::move(e, moved.begin());
+    assert(moved[1].first == 1 && moved[1].second == "b1");
+    const auto& ce = e;
+    assert((*(ce.begin() + 1)).first == 1 && ce.end() - ce.begin() == 2);
+  }
+
+  // 計測: 手書きの添字ループ、特殊化した enumerate_view、一般の enumerate_view の比較
+  {
+    // メモリ帯域で律速されないよう、L1 キャッシュに収まる配列を繰り返し走査する
+    constexpr std::size_t m = 1 << 12;
+    constexpr int iterations = 1 << 14;
+    using kernel_t = void (*)(std::span<std::uint32_t>);
+    const kernel_t kernels[]{indexed_loop, contiguous_enumerate_loop, generic_enumerate_loop};
+    double times[std::size(kernels)];
+    std::vector<std::uint32_t> results[std::size(kernels)];
+    for (std::size_t k = 0; k < std::size(kernels); ++k) {
+      results[k].assign(m, 1);
+      times[k] = 1e300;
+      for (int rep = 0; rep < 5; ++rep) {
+        const auto t0 = clock::now();
+        for (int it = 0; it < iterations; ++it)
+          kernels[k](results[k]);
+        times[k] = std::min(times[k], ms(clock::now() - t0).count());
+      }
+    }
+    assert(results[0] == results[1] && results[0] == results[2]);
+    std::cout << "indexed loop:           " << times[0] << " ms\n"
+              << "enumerate (contiguous): " << times[1] << " ms\n"
+              << "enumerate (generic):    " << times[2] << " ms\n"
+              // 特殊化した形は手書きの添字ループと同程度の速さになることが期待される
+              // 時間の比は揺れるため、ベクトル化されることは check_vectorize.sh で確かめる
+              << "contiguous / indexed:   " << times[1] / times[0] << std::endl;
+  }
+}
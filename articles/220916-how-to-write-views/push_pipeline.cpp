@@ -0,0 +1,281 @@
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+// for main
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// push 型の range pipeline
+//
+// views::filter | views::transform | views::take のような pull 型の pipeline では、
+// 段ごとに operator++, operator*, 番兵との比較が行われ、filter は更に分岐を加える。
+// ここでは各段を「下流のシンクを受け取り、上流のシンクを返す関数」として表し、
+// pipeline 全体をコンパイル時に 1 つのループ本体に融合する
+// (230325-dl-compiler-overview.md の演算子融合: 要素ごとの演算を連結し、最後の畳み込みまで 1 回の走査で行う)。
+//
+// シンクは要素を 1 つ受け取り、続行するなら true、打ち切るなら false を返す。
+// 走査は元の range を 1 度だけ回す内部イテレーションで行い、take は false を返して早期に脱出する
+namespace ns::push {
+  template <class... Stages>
+  struct pipeline;
+
+  template <std::ranges::input_range View, class... Stages>
+  requires std::ranges::view<View>
+  class push_view;
+
+  /// stages の I 番目以降をシンク sink に被せる
+  /// 0 番目の段が最も外側 (元の range に近い側) になる
+  template <std::size_t I = 0, class Tuple, class Sink>
+  constexpr auto __make_sink(const Tuple& stages, Sink sink) {
+    if constexpr (I == std::tuple_size_v<Tuple>)
+      return sink;
+    else
+      return std::get<I>(stages)(__make_sink<I + 1>(stages, std::move(sink)));
+  }
+
+  /// 段の列。range adaptor closure object と同様に、| によって合成できる
+  template <class... Stages>
+  struct pipeline {
+    std::tuple<Stages...> stages;
+
+    template <class... Others>
+    friend constexpr auto operator|(pipeline lhs, pipeline<Others...> rhs) {
+      return pipeline<Stages..., Others...>{
+        std::tuple_cat(std::move(lhs.stages), std::move(rhs.stages))};
+    }
+
+    // range | pipeline
+    template <std::ranges::viewable_range Range>
+    friend constexpr auto operator|(Range&& range, pipeline p) {
+      return push_view<std::views::all_t<Range>, Stages...>(
+        std::views::all(std::forward<Range>(range)), std::move(p.stages));
+    }
+  };
+
+  /// 元となる view と、それに適用する段の列
+  /// それ自体は range ではなく、for_each や reduce によって走査する
+  template <std::ranges::input_range View, class... Stages>
+  requires std::ranges::view<View>
+  class push_view {
+    //! 元となる view
+    View base_ = View();
+    //! 適用する段の列
+    std::tuple<Stages...> stages_;
+
+  public:
+    constexpr push_view(View base, std::tuple<Stages...> stages)
+      : base_(std::move(base)), stages_(std::move(stages)) {}
+
+    template <class... Others>
+    friend constexpr auto operator|(push_view v, pipeline<Others...> p) {
+      return push_view<View, Stages..., Others...>(
+        std::move(v.base_),
+        std::tuple_cat(std::move(v.stages_), std::move(p.stages)));
+    }
+
+    /// 各要素を、続行するなら true を返すシンク sink に渡す
+    /// 最後まで走査した場合 true、途中で打ち切られた場合 false を返す
+    template <class Sink>
+    constexpr bool run(Sink sink) {
+      auto fused = __make_sink(stages_, std::move(sink));
+      for (auto&& x : base_)
+        if (not fused(std::forward<decltype(x)>(x)))
+          return false;
+      return true;
+    }
+
+    template <class F>
+    constexpr F for_each(F f) {
+      run([&f](auto&& x) {
+        std::invoke(f, std::forward<decltype(x)>(x));
+        return true;
+      });
+      return f;
+    }
+
+    template <class T, class Op = std::plus<>>
+    constexpr T reduce(T init, Op op = Op{}) {
+      run([&](auto&& x) {
+        init = std::invoke(op, std::move(init), std::forward<decltype(x)>(x));
+        return true;
+      });
+      return init;
+    }
+  };
+
+  template <class F>
+  struct transform_stage {
+    F f;
+
+    template <class Sink>
+    constexpr auto operator()(Sink sink) const {
+      return [f = f, sink = std::move(sink)](auto&& x) mutable -> bool {
+        return sink(std::invoke(f, std::forward<decltype(x)>(x)));
+      };
+    }
+  };
+
+  template <class Pred>
+  struct filter_stage {
+    Pred pred;
+
+    template <class Sink>
+    constexpr auto operator()(Sink sink) const {
+      return [pred = pred, sink = std::move(sink)](auto&& x) mutable -> bool {
+        // 述語を満たさない要素は読み捨てて続行する
+        return not std::invoke(pred, std::as_const(x))
+               or sink(std::forward<decltype(x)>(x));
+      };
+    }
+  };
+
+  struct take_stage {
+    std::ptrdiff_t n;
+
+    // n 個目の要素を渡した直後に false を返し、次の要素を読み出さずに走査を終える
+    // ただし n == 0 の場合は、先頭の要素までは上流で評価される
+    template <class Sink>
+    constexpr auto operator()(Sink sink) const {
+      return [n = n, sink = std::move(sink)](auto&& x) mutable -> bool {
+        if (n <= 0)
+          return false;
+        return sink(std::forward<decltype(x)>(x)) and --n > 0;
+      };
+    }
+  };
+
+  struct enumerate_stage {
+    template <class Sink>
+    constexpr auto operator()(Sink sink) const {
+      return [count = std::size_t(0), sink = std::move(sink)](auto&& x) mutable -> bool {
+        return sink(std::pair<std::size_t, decltype(x)>(count++, std::forward<decltype(x)>(x)));
+      };
+    }
+  };
+
+  struct transform_fn {
+    template <class F>
+    constexpr auto operator()(F&& f) const {
+      return pipeline<transform_stage<std::decay_t<F>>>{{{std::forward<F>(f)}}};
+    }
+  };
+
+  struct filter_fn {
+    template <class Pred>
+    constexpr auto operator()(Pred&& pred) const {
+      return pipeline<filter_stage<std::decay_t<Pred>>>{{{std::forward<Pred>(pred)}}};
+    }
+  };
+
+  struct take_fn {
+    constexpr auto operator()(std::ptrdiff_t n) const {
+      return pipeline<take_stage>{{{n}}};
+    }
+  };
+
+  inline namespace cpo {
+    inline constexpr auto transform = transform_fn();
+    inline constexpr auto filter = filter_fn();
+    inline constexpr auto take = take_fn();
+    inline constexpr auto enumerate = pipeline<enumerate_stage>();
+  } // namespace cpo
+} // namespace ns::push
+
+// 計測に用いるパイプライン: 3 の倍数を取り出して 2 乗し、先頭の limit 個の和をとる
+// main に展開されると、GCC は main を 1 度しか実行されない関数とみなして最適化を抑えるため、
+// 関数ポインタを介して呼び出す
+long long pull_pipeline(const std::vector<int>& v, std::ptrdiff_t limit) {
+  long long sum = 0;
+  for (long long x : v | std::views::filter([](int x) { return x % 3 == 0; })
+                       | std::views::transform([](int x) { return 1LL * x * x; })
+                       | std::views::take(limit))
+    sum += x;
+  return sum;
+}
+
+long long push_pipeline(const std::vector<int>& v, std::ptrdiff_t limit) {
+  return (v | ns::push::filter([](int x) { return x % 3 == 0; })
+            | ns::push::transform([](int x) { return 1LL * x * x; })
+            | ns::push::take(limit))
+    .reduce(0LL);
+}
+
+long long hand_written(const std::vector<int>& v, std::ptrdiff_t limit) {
+  long long sum = 0;
+  for (std::size_t i = 0; i < v.size() and limit > 0; ++i)
+    if (v[i] % 3 == 0) {
+      sum += 1LL * v[i] * v[i];
+      --limit;
+    }
+  return sum;
+}
+
+int main() {
+  {
+    // 220916-how-to-write-views.md の冒頭の例
+    auto p = std::views::iota(0)
+             | ns::push::filter([](auto x) { return x % 2 == 0; })
+             | ns::push::transform([](auto x) { return x * x; })
+             | ns::push::take(4);
+    p.for_each([](auto x) { std::cout << x << ','; }); // output: 0,4,16,36,
+    std::cout << std::endl;
+
+    // closure 同士を先に合成してもよい
+    auto evens_squared = ns::push::filter([](int x) { return x % 2 == 0; })
+                         | ns::push::transform([](int x) { return x * x; });
+    std::vector<int> out;
+    (std::views::iota(0, 10) | evens_squared | ns::push::take(3))
+      .for_each([&](int x) { out.push_back(x); });
+    assert((out == std::vector{0, 4, 16}));
+
+    // 要素への参照は段を通して保たれる
+    std::vector<char> v{'a', 'b', 'c'};
+    (v | ns::push::enumerate | ns::push::filter([](const auto& p) { return p.first != 1; }))
+      .for_each([](auto p) { p.second = static_cast<char>(p.second - 'a' + 'A'); });
+    assert((v == std::vector{'A', 'b', 'C'}));
+
+    // take は n 個目で走査を打ち切る
+    int pulled = 0;
+    bool finished = (std::views::iota(0, 100)
+                     | ns::push::transform([&](int x) { ++pulled; return x; })
+                     | ns::push::take(5))
+                      .run([](int) { return true; });
+    assert(not finished and pulled == 5);
+    assert((std::views::iota(0, 3) | ns::push::take(5)).reduce(0) == 3);
+  }
+
+  // 計測
+  constexpr std::size_t n = 1 << 24;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(-1000, 1000);
+  std::vector<int> v(n);
+  std::ranges::generate(v, [&] { return dist(gen); });
+
+  using kernel_t = long long (*)(const std::vector<int>&, std::ptrdiff_t);
+  const kernel_t kernels[]{pull_pipeline, push_pipeline, hand_written};
+  const char* names[]{"pull (std::views):", "push:             ", "hand-written:     "};
+  // 途中で打ち切る場合と、最後まで走査する場合
+  for (std::ptrdiff_t limit : {static_cast<std::ptrdiff_t>(n / 8), static_cast<std::ptrdiff_t>(n)}) {
+    std::cout << "take(" << limit << ")" << std::endl;
+    long long expected = hand_written(v, limit);
+    for (std::size_t k = 0; k < std::size(kernels); ++k) {
+      double best = 1e300;
+      for (int rep = 0; rep < 5; ++rep) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto sum = kernels[k](v, limit);
+        const std::chrono::duration<double, std::milli> dt = std::chrono::steady_clock::now() - t0;
+        assert(sum == expected);
+        best = std::min(best, dt.count());
+      }
+      std::cout << "  " << names[k] << ' ' << best << " ms" << std::endl;
+    }
+  }
+}
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+// for main
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace ns {
+  /// L1 データキャッシュに、大きさ elem_size の要素からなる正方形のタイルが
+  /// 2 枚 (読み出し元と書き込み先) 収まる最大の一辺 (2 の冪)
+  /// キャッシュの大きさは実行時に取得し、取得できない場合は 32 KiB とみなす
+  inline std::size_t default_tile_extent(std::size_t elem_size) {
+    long l1 = -1;
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+#endif
+    if (l1 <= 0)
+      l1 = 32 * 1024;
+    std::size_t extent = 1;
+    while (2 * (2 * extent) * (2 * extent) * elem_size <= static_cast<std::size_t>(l1))
+      extent *= 2;
+    return extent;
+  }
+
+  /// 行優先の行列の矩形の部分
+  /// tile_view の要素であり、元の行列の要素を参照する
+  /// @tparam I 元となる行列のイテレータの型
+  template <std::random_access_iterator I>
+  struct tile {
+    //! タイルの左上の要素
+    I first = I();
+    //! 元の行列の列数
+    std::size_t stride = 0;
+    //! タイルの左上の要素の、元の行列における行番号と列番号
+    std::size_t row_offset = 0, col_offset = 0;
+    //! タイルの行数と列数 (右端と下端のタイルは小さくなり得る)
+    std::size_t rows = 0, cols = 0;
+
+    constexpr std::iter_reference_t<I> operator()(std::size_t i,
+                                                  std::size_t j) const {
+      return first[static_cast<std::iter_difference_t<I>>(i * stride + j)];
+    }
+    /// タイルの i 行目
+    constexpr auto row(std::size_t i) const {
+      auto b = first + static_cast<std::iter_difference_t<I>>(i * stride);
+      return std::ranges::subrange(b, b + static_cast<std::iter_difference_t<I>>(cols));
+    }
+  };
+
+  /// 行優先で格納された rows 行 cols 列の行列を、tile_rows 行 tile_cols 列のタイルごとに走査する
+  /// タイルは行優先の順に並ぶ
+  /// @tparam View 元となる view の型
+  template <std::ranges::random_access_range View>
+  requires std::ranges::view<View> and std::ranges::sized_range<View>
+  struct tile_view : std::ranges::view_interface<tile_view<View>> {
+  private:
+    //! 元となる view
+    View base_ = View();
+    //! 行列の行数と列数
+    std::size_t rows_ = 0, cols_ = 0;
+    //! タイルの行数と列数
+    std::size_t tile_rows_ = 1, tile_cols_ = 1;
+
+    template <bool Const>
+    struct iterator;
+
+    //! 横方向に並ぶタイルの数
+    constexpr std::size_t tiles_across() const noexcept {
+      return (cols_ + tile_cols_ - 1) / tile_cols_;
+    }
+    //! 縦方向に並ぶタイルの数
+    constexpr std::size_t tiles_down() const noexcept {
+      return (rows_ + tile_rows_ - 1) / tile_rows_;
+    }
+
+  public:
+    tile_view() requires std::default_initializable<View> = default;
+    constexpr tile_view(View base, std::size_t rows, std::size_t cols,
+                        std::size_t tile_rows, std::size_t tile_cols)
+      : base_(std::move(base)), rows_(rows), cols_(cols),
+        tile_rows_(tile_rows), tile_cols_(tile_cols) {
+      assert(tile_rows_ > 0 and tile_cols_ > 0);
+      assert(rows_ * cols_ == std::ranges::size(base_));
+    }
+
+    constexpr View base() const& requires std::copy_constructible<View> {
+      return base_;
+    }
+    constexpr View base() && { return std::move(base_); }
+
+    constexpr std::size_t rows() const noexcept { return rows_; }
+    constexpr std::size_t cols() const noexcept { return cols_; }
+    constexpr std::size_t tile_rows() const noexcept { return tile_rows_; }
+    constexpr std::size_t tile_cols() const noexcept { return tile_cols_; }
+
+    constexpr iterator<false> begin() { return {*this, 0}; }
+    constexpr iterator<true>
+    begin() const requires std::ranges::random_access_range<const View> {
+      return {*this, 0};
+    }
+
+    constexpr iterator<false> end() { return {*this, size()}; }
+    constexpr iterator<true>
+    end() const requires std::ranges::random_access_range<const View> {
+      return {*this, size()};
+    }
+
+    constexpr std::size_t size() const noexcept {
+      return tiles_down() * tiles_across();
+    }
+  };
+
+  template <class Range>
+  tile_view(Range&&, std::size_t, std::size_t, std::size_t, std::size_t)
+    -> tile_view<std::views::all_t<Range>>;
+
+  template <std::ranges::random_access_range View>
+  requires std::ranges::view<View> and std::ranges::sized_range<View>
+  template <bool Const>
+  struct tile_view<View>::iterator {
+  private:
+    template <bool>
+    friend struct iterator;
+
+    using Parent = std::conditional_t<Const, const tile_view, tile_view>;
+    using Base = std::conditional_t<Const, const View, View>;
+    //! 走査中の tile_view
+    Parent* parent_ = nullptr;
+    //! 現在のタイルの番号
+    std::size_t index_ = 0;
+
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = tile<std::ranges::iterator_t<Base>>;
+    using iterator_concept = std::random_access_iterator_tag;
+    // 間接参照演算子が左辺値参照を返さないため Cpp17InputIterator 止まり
+    using iterator_category = std::input_iterator_tag;
+
+    iterator() = default;
+    constexpr iterator(Parent& parent, std::size_t index)
+      : parent_(std::addressof(parent)), index_(index) {}
+    constexpr iterator(iterator<not Const> i) requires Const and
+      std::convertible_to<std::ranges::iterator_t<View>,
+                          std::ranges::iterator_t<Base>>
+      : parent_(i.parent_), index_(i.index_) {}
+
+    constexpr value_type operator*() const {
+      const auto across = parent_->tiles_across();
+      const auto r0 = index_ / across * parent_->tile_rows_;
+      const auto c0 = index_ % across * parent_->tile_cols_;
+      return {std::ranges::begin(parent_->base_)
+                + static_cast<std::ranges::range_difference_t<Base>>(
+                  r0 * parent_->cols_ + c0),
+              parent_->cols_,
+              r0,
+              c0,
+              std::min(parent_->tile_rows_, parent_->rows_ - r0),
+              std::min(parent_->tile_cols_, parent_->cols_ - c0)};
+    }
+    constexpr value_type operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    constexpr iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    constexpr iterator operator++(int) {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    constexpr iterator& operator--() {
+      --index_;
+      return *this;
+    }
+    constexpr iterator operator--(int) {
+      auto tmp = *this;
+      --*this;
+      return tmp;
+    }
+
+    constexpr iterator& operator+=(difference_type n) {
+      index_ += n;
+      return *this;
+    }
+    constexpr iterator& operator-=(difference_type n) { return *this += -n; }
+    friend constexpr iterator operator+(iterator x, difference_type n) {
+      x += n;
+      return x;
+    }
+    friend constexpr iterator operator+(difference_type n, iterator x) {
+      x += n;
+      return x;
+    }
+    friend constexpr iterator operator-(iterator x, difference_type n) {
+      x -= n;
+      return x;
+    }
+    friend constexpr difference_type operator-(const iterator& x,
+                                               const iterator& y) {
+      return static_cast<difference_type>(x.index_ - y.index_);
+    }
+
+    friend constexpr bool operator==(const iterator& x, const iterator& y) {
+      return x.index_ == y.index_;
+    }
+    friend constexpr auto operator<=>(const iterator& x, const iterator& y) {
+      return x.index_ <=> y.index_;
+    }
+  };
+
+  // 行列の形とタイルの大きさを保持し、range を受け取って tile_view を構築する
+  // タイルの大きさが 0 の場合は、要素の大きさと L1 キャッシュの大きさから定める
+  struct tile_closure : std::ranges::range_adaptor_closure<tile_closure> {
+    std::size_t rows, cols, tile_rows, tile_cols;
+
+    template <std::ranges::viewable_range Range>
+    constexpr auto operator()(Range&& range) const {
+      std::size_t tr = tile_rows, tc = tile_cols;
+      if (tr == 0 or tc == 0)
+        tr = tc = default_tile_extent(sizeof(std::ranges::range_value_t<Range>));
+      return tile_view(std::forward<Range>(range), rows, cols, tr, tc);
+    }
+  };
+
+  struct tile_fn {
+    template <std::ranges::viewable_range Range>
+    constexpr auto operator()(Range&& range, std::size_t rows, std::size_t cols,
+                              std::size_t tile_rows, std::size_t tile_cols) const {
+      return tile_view(std::forward<Range>(range), rows, cols, tile_rows, tile_cols);
+    }
+
+    constexpr tile_closure operator()(std::size_t rows, std::size_t cols,
+                                      std::size_t tile_rows, std::size_t tile_cols) const {
+      return {{}, rows, cols, tile_rows, tile_cols};
+    }
+    /// タイルの大きさを L1 キャッシュの大きさから定める
+    constexpr tile_closure operator()(std::size_t rows, std::size_t cols) const {
+      return {{}, rows, cols, 0, 0};
+    }
+  };
+
+  namespace views {
+    inline constexpr auto tile = tile_fn();
+  } // namespace views
+} // namespace ns
+
+// 計測に用いるカーネル
+// main に展開されると、GCC は main を 1 度しか実行されない関数とみなして最適化を抑えるため、
+// 関数ポインタを介して呼び出す
+using matrix = std::vector<double>;
+
+// b = a^T (a は n 行 n 列)
+void transpose_naive(const matrix& a, matrix& b, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < n; ++j)
+      b[j * n + i] = a[i * n + j];
+}
+
+void transpose_tiled(const matrix& a, matrix& b, std::size_t n) {
+  for (auto t : a | ns::views::tile(n, n))
+    for (std::size_t i = 0; i < t.rows; ++i)
+      for (std::size_t j = 0; j < t.cols; ++j)
+        b[(t.col_offset + j) * n + t.row_offset + i] = t(i, j);
+}
+
+// c = a * b (いずれも n 行 n 列)。行ごとに走査する i-k-j の順のループ
+void matmul_naive(const matrix& a, const matrix& b, matrix& c, std::size_t n) {
+  std::ranges::fill(c, 0.0);
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t k = 0; k < n; ++k)
+      for (std::size_t j = 0; j < n; ++j)
+        c[i * n + j] += a[i * n + k] * b[k * n + j];
+}
+
+// c のタイルごとに、a の対応する行と b の対応するタイルを掛け合わせる
+void matmul_tiled(const matrix& a, const matrix& b, matrix& c, std::size_t n) {
+  std::ranges::fill(c, 0.0);
+  const std::size_t extent = ns::default_tile_extent(sizeof(double));
+  for (auto t : c | ns::views::tile(n, n, extent, extent))
+    for (std::size_t k0 = 0; k0 < n; k0 += extent)
+      for (std::size_t i = 0; i < t.rows; ++i)
+        for (std::size_t k = k0; k < std::min(n, k0 + extent); ++k) {
+          const double aik = a[(t.row_offset + i) * n + k];
+          for (std::size_t j = 0; j < t.cols; ++j)
+            t(i, j) += aik * b[k * n + t.col_offset + j];
+        }
+}
+
+int main() {
+  {
+    // 3 行 5 列の行列を 2 行 2 列のタイルに分ける
+    std::vector<int> v(15);
+    std::iota(v.begin(), v.end(), 0);
+    auto tiles = v | ns::views::tile(3, 5, 2, 2);
+    static_assert(std::ranges::random_access_range<decltype(tiles)>);
+    static_assert(std::ranges::sized_range<decltype(tiles)>);
+    static_assert(std::ranges::random_access_range<const decltype(tiles)>);
+    assert(tiles.size() == 6);
+    std::vector<int> order;
+    for (auto t : tiles)
+      for (std::size_t i = 0; i < t.rows; ++i)
+        for (int x : t.row(i))
+          order.push_back(x);
+    assert((order == std::vector{0, 1, 5, 6, 2, 3, 7, 8, 4, 9, 10, 11, 12, 13, 14}));
+    // 右下のタイルは 1 行 1 列
+    const auto& ct = tiles;
+    auto last = ct[5];
+    assert(last.rows == 1 && last.cols == 1 && last.row_offset == 2 && last.col_offset == 4);
+    assert(last(0, 0) == 14);
+    // タイルを通して書き換えられる
+    tiles[0](1, 1) = -1;
+    assert(v[6] == -1);
+  }
+
+  std::cout << "tile extent for double: " << ns::default_tile_extent(sizeof(double)) << std::endl;
+
+  using clock = std::chrono::steady_clock;
+  using ms = std::chrono::duration<double, std::milli>;
+  auto best_of = [](auto f) {
+    double best = 1e300;
+    for (int rep = 0; rep < 3; ++rep) {
+      const auto t0 = clock::now();
+      f();
+      best = std::min(best, ms(clock::now() - t0).count());
+    }
+    return best;
+  };
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-1, 1);
+
+  // 計測: 転置
+  {
+    constexpr std::size_t n = 4096;
+    matrix a(n * n), b1(n * n), b2(n * n);
+    std::ranges::generate(a, [&] { return dist(gen); });
+    using kernel_t = void (*)(const matrix&, matrix&, std::size_t);
+    const kernel_t naive = transpose_naive, tiled = transpose_tiled;
+    const auto t_naive = best_of([&] { naive(a, b1, n); });
+    const auto t_tiled = best_of([&] { tiled(a, b2, n); });
+    assert(b1 == b2);
+    std::cout << "transpose " << n << "x" << n << ": naive " << t_naive
+              << " ms, tiled " << t_tiled << " ms" << std::endl;
+  }
+
+  // 計測: 行列積
+  {
+    constexpr std::size_t n = 1024;
+    matrix a(n * n), b(n * n), c1(n * n), c2(n * n);
+    std::ranges::generate(a, [&] { return dist(gen); });
+    std::ranges::generate(b, [&] { return dist(gen); });
+    using kernel_t = void (*)(const matrix&, const matrix&, matrix&, std::size_t);
+    const kernel_t naive = matmul_naive, tiled = matmul_tiled;
+    const auto t_naive = best_of([&] { naive(a, b, c1, n); });
+    const auto t_tiled = best_of([&] { tiled(a, b, c2, n); });
+    // 加算の順序は同じであるため、結果は一致する
+    assert(c1 == c2);
+    std::cout << "matmul " << n << "x" << n << ": naive " << t_naive
+              << " ms, tiled " << t_tiled << " ms" << std::endl;
+  }
+}
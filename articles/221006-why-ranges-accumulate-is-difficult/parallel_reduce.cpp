@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// for main
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <string>
+
+namespace _ranges {
+  // clang-format off
+
+  // draft.cpp より
+  template <class Op, class T, class U>
+  concept magma =
+    std::common_with<T, U> and
+    std::regular_invocable<Op, T, T> and
+    std::regular_invocable<Op, U, U> and
+    std::regular_invocable<Op, T, U> and
+    std::regular_invocable<Op, U, T> and
+    std::common_with<std::invoke_result_t<Op&, T, U>, T> and
+    std::common_with<std::invoke_result_t<Op&, T, U>, U> and
+    std::same_as<std::invoke_result_t<Op&, T, U>, std::invoke_result_t<Op&, U, T>>;
+
+  template <class Op, class I1, class I2, class O>
+  concept indirect_magma =
+    std::indirectly_readable<I1> and
+    std::indirectly_readable<I2> and
+    std::indirectly_writable<O, std::indirect_result_t<Op&, I1, I2>> and
+    magma<Op&, std::iter_value_t<I1>&, std::iter_value_t<I2>&> and
+    magma<Op&, std::iter_value_t<I1>&, std::iter_reference_t<I2>&> and
+    magma<Op&, std::iter_reference_t<I1>, std::iter_value_t<I2>&> and
+    magma<Op&, std::iter_reference_t<I1>, std::iter_reference_t<I2>> and
+    magma<Op&, std::iter_common_reference_t<I1>, std::iter_common_reference_t<I2>>;
+
+  // 結合則はコンセプトでは検査できないため、演算子の型ごとに明示的に宣言する
+  // (ranges::enable_borrowed_range と同様のオプトイン)
+  template <class Op>
+  inline constexpr bool enable_associative = false;
+  template <>
+  inline constexpr bool enable_associative<std::plus<>> = true;
+  template <>
+  inline constexpr bool enable_associative<std::multiplies<>> = true;
+  template <>
+  inline constexpr bool enable_associative<std::bit_and<>> = true;
+  template <>
+  inline constexpr bool enable_associative<std::bit_or<>> = true;
+  template <>
+  inline constexpr bool enable_associative<std::bit_xor<>> = true;
+  template <>
+  inline constexpr bool enable_associative<std::remove_cvref_t<decltype(std::ranges::max)>> = true;
+  template <>
+  inline constexpr bool enable_associative<std::remove_cvref_t<decltype(std::ranges::min)>> = true;
+
+  template <class Op, class I1, class I2, class O>
+  concept indirect_semigroup =
+    indirect_magma<Op, I1, I2, O> and
+    enable_associative<std::remove_cvref_t<Op>>;
+
+  // clang-format on
+
+  struct reduce_fn {
+  private:
+    //! 1 スレッドに割り当てる要素数の下限
+    static constexpr std::ptrdiff_t min_chunk_size = 1 << 14;
+
+    template <class I, class T, class Op, class P>
+    static constexpr T fold_chunk(I first, I last, T init, Op& op, P& proj) {
+      for (; first != last; ++first)
+        init = std::invoke(op, std::move(init), std::invoke(proj, *first));
+      return init;
+    }
+
+  public:
+    template <class I, class S, class T, class Op = std::plus<>,
+              class P = std::identity>
+    requires std::sentinel_for<S, I> and std::input_iterator<I> and
+      indirect_semigroup<Op, const T*, std::projected<I, P>, T*>
+    constexpr T operator()(I first, S last, T init, Op op = Op{},
+                           P proj = P{}) const {
+      return fold_chunk(std::move(first), std::move(last), std::move(init), op,
+                        proj);
+    }
+
+    template <class R, class T, class Op = std::plus<>, class P = std::identity>
+    requires std::ranges::input_range<R> and indirect_semigroup<
+      Op, const T*, std::projected<std::ranges::iterator_t<R>, P>, T*>
+    constexpr T operator()(R&& r, T init, Op op = Op{}, P proj = P{}) const {
+      return (*this)(std::ranges::begin(r), std::ranges::end(r),
+                     std::move(init), std::move(op), std::move(proj));
+    }
+
+    // 実行ポリシーを受け取るオーバーロード
+    // random_access_range かつ sized_range の場合、範囲を分割して各部分を
+    // ワーカースレッドで畳み込み、部分和を二分木状に結合する
+    template <class E, class R, class T, class Op = std::plus<>,
+              class P = std::identity>
+    requires std::is_execution_policy_v<std::remove_cvref_t<E>> and
+      std::ranges::input_range<R> and indirect_semigroup<
+        Op, const T*, std::projected<std::ranges::iterator_t<R>, P>, T*>
+    T operator()(E&&, R&& r, T init, Op op = Op{}, P proj = P{}) const {
+      constexpr bool sequenced =
+        std::same_as<std::remove_cvref_t<E>,
+                     std::execution::sequenced_policy>;
+      if constexpr (sequenced or not std::ranges::random_access_range<R> or
+                    not std::ranges::sized_range<R>) {
+        return (*this)(std::forward<R>(r), std::move(init), std::move(op),
+                       std::move(proj));
+      } else {
+        const auto first = std::ranges::begin(r);
+        const auto n = static_cast<std::ptrdiff_t>(std::ranges::size(r));
+        const auto hw = std::max<std::ptrdiff_t>(
+          std::thread::hardware_concurrency(), 1);
+        const auto nchunks =
+          std::clamp<std::ptrdiff_t>(n / min_chunk_size, 1, hw);
+        if (nchunks == 1)
+          return fold_chunk(first, first + n, std::move(init), op, proj);
+
+        // 先頭の部分は init を、それ以外は部分の先頭要素を初期値とする
+        // 結合の順序は保たれるため、可換性は要求しない
+        auto bound = [&](std::ptrdiff_t i) { return first + n * i / nchunks; };
+        std::vector<T> partials;
+        partials.reserve(nchunks);
+        partials.push_back(std::move(init));
+        for (std::ptrdiff_t i = 1; i < nchunks; ++i)
+          partials.emplace_back(std::invoke(proj, *bound(i)));
+
+        std::vector<std::exception_ptr> errors(nchunks);
+        {
+          std::vector<std::jthread> workers;
+          workers.reserve(nchunks - 1);
+          auto work = [&](std::ptrdiff_t i) {
+            try {
+              auto b = bound(i) + (i == 0 ? 0 : 1);
+              partials[i] =
+                fold_chunk(b, bound(i + 1), std::move(partials[i]), op, proj);
+            } catch (...) {
+              errors[i] = std::current_exception();
+            }
+          };
+          for (std::ptrdiff_t i = 1; i < nchunks; ++i)
+            workers.emplace_back(work, i);
+          work(0);
+        } // join
+        for (auto& e : errors)
+          if (e)
+            std::rethrow_exception(e);
+
+        // 二分木状に結合する: 段ごとに隣り合う部分和を畳み込む
+        for (std::ptrdiff_t stride = 1; stride < nchunks; stride *= 2)
+          for (std::ptrdiff_t i = 0; i + stride < nchunks; i += 2 * stride)
+            partials[i] = std::invoke(op, std::move(partials[i]),
+                                      std::move(partials[i + stride]));
+        return std::move(partials[0]);
+      }
+    }
+  };
+
+  inline constexpr reduce_fn reduce{};
+} // namespace _ranges
+
+struct concat_fn {
+  std::string operator()(std::string x, const std::string& y) const {
+    return std::move(x += y);
+  }
+};
+template <>
+inline constexpr bool _ranges::enable_associative<concat_fn> = true;
+
+int main() {
+  {
+    std::vector<long long> v(10'000'000);
+    std::iota(v.begin(), v.end(), 0LL);
+    const auto expected = std::accumulate(v.begin(), v.end(), 42LL);
+    assert(_ranges::reduce(v, 42LL) == expected);
+    assert(_ranges::reduce(std::execution::par, v, 42LL) == expected);
+    assert(_ranges::reduce(std::execution::seq, v, 42LL) == expected);
+    assert(_ranges::reduce(std::execution::par, v, 0LL, std::ranges::max)
+           == v.back());
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    volatile auto seq = _ranges::reduce(std::execution::seq, v, 0LL);
+    auto t1 = clock::now();
+    volatile auto par = _ranges::reduce(std::execution::par, v, 0LL);
+    auto t2 = clock::now();
+    (void)seq, (void)par;
+    std::cout << "seq: " << std::chrono::duration<double, std::milli>(t1 - t0).count()
+              << " ms, par: " << std::chrono::duration<double, std::milli>(t2 - t1).count()
+              << " ms" << std::endl;
+  }
+  {
+    // 可換でない演算でも結合の順序は保たれる
+    std::vector<std::string> v(100'000);
+    for (std::size_t i = 0; i < v.size(); ++i)
+      v[i] = static_cast<char>('a' + i % 26);
+    assert(_ranges::reduce(std::execution::par, v, std::string{}, concat_fn{})
+           == _ranges::reduce(v, std::string{}, concat_fn{}));
+    // enable_associative を宣言していない演算子は受け付けない
+    static_assert(not std::invocable<_ranges::reduce_fn, decltype(v)&,
+                                     std::string, std::minus<>>);
+  }
+  {
+    // random_access_range でない場合は逐次実行に退化する
+    std::vector<int> v{1, 2, 3, 4};
+    auto r = v | std::views::filter([](int x) { return x % 2 == 0; });
+    assert(_ranges::reduce(std::execution::par, r, 0) == 6);
+  }
+}
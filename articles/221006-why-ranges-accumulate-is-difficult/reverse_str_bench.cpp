@@ -0,0 +1,95 @@
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <utility>
+// for main
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+namespace _ranges {
+  template <class... Args>
+  concept indirectly_binary_invocable = true;
+
+  struct accumulate_fn {
+    template <class R, class T, class Op = std::plus<>, class P = std::identity>
+    requires std::ranges::input_range<R> and indirectly_binary_invocable<
+      Op, T*, std::projected<std::ranges::iterator_t<R>, P>> and std::
+      assignable_from<T&,
+                      std::indirect_result_t<
+                        Op&, T*, std::projected<std::ranges::iterator_t<R>, P>>>
+    constexpr T operator()(R&& r, T init, Op op = Op{}, P proj = P{}) const {
+      for (auto&& x : r)
+        init = std::invoke(op, std::move(init), std::invoke(proj, x));
+      return init;
+    }
+  };
+
+  inline constexpr accumulate_fn accumulate{};
+
+  struct accumulate_into_fn {
+    template <class R, class T, class Op, class P = std::identity>
+    requires std::ranges::input_range<R> and std::invocable<
+      Op&, T&, std::indirect_result_t<P&, std::ranges::iterator_t<R>>>
+    constexpr T operator()(R&& r, T init, Op op, P proj = P{}) const {
+      for (auto&& x : r)
+        std::invoke(op, init, std::invoke(proj, x));
+      return init;
+    }
+  };
+
+  inline constexpr accumulate_into_fn accumulate_into{};
+} // namespace _ranges
+
+using namespace std;
+
+// 従来の実装: 毎回先頭に連結するため O(n^2)
+string reverse_str_prepend(const string& str) {
+  return _ranges::accumulate(str, string{}, [](auto&& str, char c) {
+    return c + forward<decltype(str)>(str);
+  });
+}
+
+// in-place に末尾へ追加する実装: O(n)、メモリ確保は 1 回
+string reverse_str(const string& str) {
+  string init;
+  init.reserve(str.size());
+  return _ranges::accumulate_into(str | views::reverse, std::move(init),
+                                  [](string& s, char c) { s.push_back(c); });
+}
+
+template <class F>
+double measure(F f) {
+  auto t0 = chrono::steady_clock::now();
+  f();
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - t0)
+    .count();
+}
+
+int main() {
+  assert(reverse_str("string"s) == "gnirts"s);
+  assert(reverse_str_prepend("string"s) == "gnirts"s);
+
+  // 従来の実装は 256 KiB を超えると数秒以上を要するため、計測を省略する
+  constexpr size_t prepend_limit = size_t{1} << 18;
+  cout << "size [bytes]\tprepend [ms]\tinto [ms]\n";
+  for (size_t n = size_t{1} << 16; n <= size_t{1} << 25; n *= 2) {
+    string str(n, '\0');
+    for (size_t i = 0; i < n; ++i)
+      str[i] = static_cast<char>('a' + i % 26);
+    string r1, r2;
+    const double t_into = measure([&] { r2 = reverse_str(str); });
+    cout << n << '\t';
+    if (n <= prepend_limit) {
+      cout << measure([&] { r1 = reverse_str_prepend(str); });
+      assert(r1 == r2);
+    } else {
+      cout << '-';
+    }
+    cout << '\t' << t_into << '\n';
+  }
+}
@@ -39,6 +39,30 @@ namespace _ranges {
   };
 
   inline constexpr accumulate_fn accumulate{};
+
+  // 累積値を参照で受け取り in-place に更新する畳み込み
+  // op(init, elem) の戻り値は捨てられ、init はムーブ代入されない
+  struct accumulate_into_fn {
+    template <class I, class S, class T, class Op, class P = std::identity>
+    requires std::sentinel_for<S, I> and std::input_iterator<I> and std::
+      invocable<Op&, T&, std::indirect_result_t<P&, I>>
+    constexpr T operator()(I first, S last, T init, Op op,
+                           P proj = P{}) const {
+      for (; first != last; ++first)
+        std::invoke(op, init, std::invoke(proj, *first));
+      return init;
+    }
+
+    template <class R, class T, class Op, class P = std::identity>
+    requires std::ranges::input_range<R> and std::invocable<
+      Op&, T&, std::indirect_result_t<P&, std::ranges::iterator_t<R>>>
+    constexpr T operator()(R&& r, T init, Op op, P proj = P{}) const {
+      return (*this)(std::ranges::begin(r), std::ranges::end(r),
+                     std::move(init), std::move(op), std::move(proj));
+    }
+  };
+
+  inline constexpr accumulate_into_fn accumulate_into{};
 } // namespace _ranges
 
 using namespace std;
@@ -69,10 +93,13 @@ Complex rotate_greatest_radius(const vector<Complex>& v) {
   }).cartesian();
 }
 
+// 先頭に文字を連結すると毎回文字列全体がコピーされ O(n^2) となるため、
+// 逆順に走査して末尾に追加する
 string reverse_str(const string& str) {
-  return _ranges::accumulate(str, string{}, [](auto&& str, char c) {
-    return c + forward<decltype(str)>(str);
-  });
+  string init;
+  init.reserve(str.size());
+  return _ranges::accumulate_into(str | views::reverse, std::move(init),
+                                  [](string& s, char c) { s.push_back(c); });
 }
 
 int main() {
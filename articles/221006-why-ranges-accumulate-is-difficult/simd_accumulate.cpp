@@ -0,0 +1,274 @@
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+// for main
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace _ranges {
+  template <class... Args>
+  concept indirectly_binary_invocable = true;
+
+  // 浮動小数点数の畳み込みにおいて、演算の順序を入れ替えてよいことを表すタグ
+  // このタグを渡した場合に限り、float/double の和・最大値・最小値を
+  // 複数のアキュムレータに分けて計算する (結果は逐次計算と丸め誤差の範囲で異なる)
+  struct reassociate_t {
+    explicit reassociate_t() = default;
+  };
+  inline constexpr reassociate_t reassociate{};
+
+  namespace __simd {
+    enum class kind { plus, max, min };
+
+    template <class Op, class T>
+    inline constexpr auto kind_of = std::nullopt;
+    template <class T>
+    inline constexpr auto kind_of<std::plus<>, T> = kind::plus;
+    template <class T>
+    inline constexpr auto kind_of<std::plus<T>, T> = kind::plus;
+    template <class T>
+    inline constexpr auto
+      kind_of<std::remove_cvref_t<decltype(std::ranges::max)>, T> = kind::max;
+    template <class T>
+    inline constexpr auto
+      kind_of<std::remove_cvref_t<decltype(std::ranges::min)>, T> = kind::min;
+
+    template <class T>
+    concept element =
+      (std::integral<T> and not std::same_as<T, bool>
+       and sizeof(T) >= sizeof(int))
+      or std::same_as<T, float> or std::same_as<T, double>;
+
+    // 特殊化された経路を用いてよいか
+    // 整数の和は符号なし整数で計算するため、順序を入れ替えても結果は変わらない
+    template <class I, class S, class T, class Op, class P, bool Reassociate>
+    concept applicable =
+      std::contiguous_iterator<I> and std::sized_sentinel_for<S, I> and
+      std::same_as<std::iter_value_t<I>, T> and element<T> and
+      std::same_as<P, std::identity> and
+      std::same_as<std::remove_const_t<decltype(kind_of<Op, T>)>, kind> and
+      (Reassociate or std::integral<T>);
+
+    // 符号付き整数の和は途中でオーバーフローしうるため、符号なし整数で計算する
+    template <class T>
+    struct wrapping {
+      using type = T;
+    };
+    template <std::integral T>
+    struct wrapping<T> {
+      using type = std::make_unsigned_t<T>;
+    };
+
+    template <kind K, class T>
+    [[gnu::always_inline]] inline T combine(T x, T y) {
+      if constexpr (K == kind::plus)
+        return x + y;
+      else if constexpr (K == kind::max)
+        return x < y ? y : x;
+      else
+        return y < x ? y : x;
+    }
+
+    // 依存関係を断ち切るため、1 レジスタ (最大 512 bit) 分の独立したアキュムレータを
+    // 並べて畳み込む。ループは命令セットに応じてコンパイラによりベクトル化される
+    template <kind K, class T>
+    [[gnu::always_inline]] inline T kernel(const T* p, std::size_t n, T init) {
+      using U =
+        std::conditional_t<K == kind::plus, typename wrapping<T>::type, T>;
+      constexpr std::size_t lanes = 64 / sizeof(T);
+      std::size_t i = 0;
+      U result = static_cast<U>(init);
+      if (n >= lanes) {
+        U acc[lanes];
+        for (std::size_t j = 0; j < lanes; ++j)
+          acc[j] = static_cast<U>(p[j]);
+        for (i = lanes; i + lanes <= n; i += lanes)
+          for (std::size_t j = 0; j < lanes; ++j)
+            acc[j] = combine<K>(acc[j], static_cast<U>(p[i + j]));
+        for (std::size_t w = lanes / 2; w > 0; w /= 2)
+          for (std::size_t j = 0; j < w; ++j)
+            acc[j] = combine<K>(acc[j], acc[j + w]);
+        result = combine<K>(result, acc[0]);
+      }
+      for (; i < n; ++i)
+        result = combine<K>(result, static_cast<U>(p[i]));
+      return static_cast<T>(result);
+    }
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+    template <kind K, class T>
+    [[gnu::target("avx512f")]] T kernel_avx512(const T* p, std::size_t n,
+                                               T init) {
+      return kernel<K>(p, n, init);
+    }
+
+    template <kind K, class T>
+    [[gnu::target("avx2")]] T kernel_avx2(const T* p, std::size_t n, T init) {
+      return kernel<K>(p, n, init);
+    }
+#endif
+
+    template <kind K, class T>
+    T kernel_default(const T* p, std::size_t n, T init) {
+      return kernel<K>(p, n, init);
+    }
+
+    // 実行時に CPU の対応する命令セットを調べ、カーネルを選択する
+    template <kind K, class T>
+    T dispatch(const T* p, std::size_t n, T init) {
+      using fn_t = T (*)(const T*, std::size_t, T);
+      static const fn_t fn = []() -> fn_t {
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+        if (__builtin_cpu_supports("avx512f"))
+          return kernel_avx512<K, T>;
+        if (__builtin_cpu_supports("avx2"))
+          return kernel_avx2<K, T>;
+#endif
+        return kernel_default<K, T>;
+      }();
+      return fn(p, n, init);
+    }
+  } // namespace __simd
+
+  struct accumulate_fn {
+  private:
+    template <bool Reassociate, class I, class S, class T, class Op, class P>
+    static constexpr T impl(I first, S last, T init, Op& op, P& proj) {
+      if constexpr (__simd::applicable<I, S, T, Op, P, Reassociate>) {
+        if (not std::is_constant_evaluated())
+          return __simd::dispatch<__simd::kind_of<Op, T>>(
+            std::to_address(first), static_cast<std::size_t>(last - first),
+            std::move(init));
+      }
+      for (; first != last; ++first)
+        init = std::invoke(op, std::move(init), std::invoke(proj, *first));
+      return init;
+    }
+
+  public:
+    template <class I, class S, class T, class Op = std::plus<>,
+              class P = std::identity>
+    requires std::sentinel_for<S, I> and std::input_iterator<
+      I> and indirectly_binary_invocable<Op, T*, std::projected<I, P>> and std::
+      assignable_from<T&, std::indirect_result_t<Op&, T*, std::projected<I, P>>>
+    constexpr T operator()(I first, S last, T init, Op op = Op{},
+                           P proj = P{}) const {
+      return impl<false>(std::move(first), std::move(last), std::move(init),
+                         op, proj);
+    }
+
+    template <class R, class T, class Op = std::plus<>, class P = std::identity>
+    requires std::ranges::input_range<R> and indirectly_binary_invocable<
+      Op, T*, std::projected<std::ranges::iterator_t<R>, P>> and std::
+      assignable_from<T&,
+                      std::indirect_result_t<
+                        Op&, T*, std::projected<std::ranges::iterator_t<R>, P>>>
+    constexpr T operator()(R&& r, T init, Op op = Op{}, P proj = P{}) const {
+      return (*this)(std::ranges::begin(r), std::ranges::end(r),
+                     std::move(init), std::move(op), std::move(proj));
+    }
+
+    template <class I, class S, class T, class Op = std::plus<>,
+              class P = std::identity>
+    requires std::sentinel_for<S, I> and std::input_iterator<
+      I> and indirectly_binary_invocable<Op, T*, std::projected<I, P>> and std::
+      assignable_from<T&, std::indirect_result_t<Op&, T*, std::projected<I, P>>>
+    constexpr T operator()(reassociate_t, I first, S last, T init,
+                           Op op = Op{}, P proj = P{}) const {
+      return impl<true>(std::move(first), std::move(last), std::move(init), op,
+                        proj);
+    }
+
+    template <class R, class T, class Op = std::plus<>, class P = std::identity>
+    requires std::ranges::input_range<R> and indirectly_binary_invocable<
+      Op, T*, std::projected<std::ranges::iterator_t<R>, P>> and std::
+      assignable_from<T&,
+                      std::indirect_result_t<
+                        Op&, T*, std::projected<std::ranges::iterator_t<R>, P>>>
+    constexpr T operator()(reassociate_t, R&& r, T init, Op op = Op{},
+                           P proj = P{}) const {
+      return (*this)(reassociate, std::ranges::begin(r), std::ranges::end(r),
+                     std::move(init), std::move(op), std::move(proj));
+    }
+  };
+
+  inline constexpr accumulate_fn accumulate{};
+} // namespace _ranges
+
+template <class F>
+double measure(F f) {
+  using clock = std::chrono::steady_clock;
+  double best = 1e300;
+  for (int i = 0; i < 5; ++i) {
+    auto t0 = clock::now();
+    f();
+    best = std::min(
+      best, std::chrono::duration<double, std::milli>(clock::now() - t0).count());
+  }
+  return best;
+}
+
+int main() {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> d(1 << 24);
+  for (auto& x : d)
+    x = dist(gen);
+  std::vector<int> n(1 << 24);
+  for (int i = 0; auto& x : n)
+    x = (i++ % 1000) - 500;
+
+  // 整数は順序を入れ替えても結果が一致する
+  assert(_ranges::accumulate(n, 0) == std::accumulate(n.begin(), n.end(), 0));
+  assert(_ranges::accumulate(n, 0, std::ranges::max) == 499);
+  assert(_ranges::accumulate(n, 0, std::ranges::min) == -500);
+  // 浮動小数点数はタグを渡した場合のみ並べ替える
+  const double seq = std::accumulate(d.begin(), d.end(), 0.0);
+  assert(_ranges::accumulate(d, 0.0) == seq);
+  assert(std::abs(_ranges::accumulate(_ranges::reassociate, d, 0.0) - seq)
+         < 1e-6);
+  assert(_ranges::accumulate(_ranges::reassociate, d, -2.0, std::ranges::max)
+         == *std::ranges::max_element(d));
+  static_assert(_ranges::accumulate(std::array{1, 2, 3}, 0) == 6);
+
+  // 特殊化されない演算子 (ラムダ式) を渡すと従来のループになる
+  auto generic_plus = [](auto x, auto y) { return x + y; };
+  volatile double sink = 0.0;
+  std::cout << "double plus   generic: "
+            << measure([&] { sink = _ranges::accumulate(d, 0.0, generic_plus); })
+            << " ms, reassociate: "
+            << measure([&] {
+                 sink = _ranges::accumulate(_ranges::reassociate, d, 0.0);
+               })
+            << " ms\n";
+  std::cout << "double max    generic: "
+            << measure([&] {
+                 sink = _ranges::accumulate(
+                   d, -2.0, [](double x, double y) { return x < y ? y : x; });
+               })
+            << " ms, reassociate: "
+            << measure([&] {
+                 sink = _ranges::accumulate(_ranges::reassociate, d, -2.0,
+                                            std::ranges::max);
+               })
+            << " ms\n";
+  volatile int isink = 0;
+  std::cout << "int    plus   generic: "
+            << measure([&] { isink = _ranges::accumulate(n, 0, generic_plus); })
+            << " ms, specialized: "
+            << measure([&] { isink = _ranges::accumulate(n, 0); }) << " ms"
+            << std::endl;
+}
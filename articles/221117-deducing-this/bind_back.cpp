@@ -11,8 +11,9 @@ namespace ns {
 
   template <class F, std::size_t... I, class... Bound>
   struct bind_back_t<F, std::index_sequence<I...>, Bound...> {
-    F f;
-    std::tuple<Bound...> bound;
+    // 状態を持たない F や束縛引数は領域を占めない
+    [[no_unique_address]] F f;
+    [[no_unique_address]] std::tuple<Bound...> bound;
 
     template <class Self, class... Args>
     constexpr auto operator()(this Self&& self, Args&&... args) noexcept(
@@ -44,4 +45,18 @@ namespace ns {
 int main() {
   constexpr auto minus_one = ns::bind_back(std::minus{}, 1);
   std::cout << minus_one(42) << std::endl;
+
+  // 状態を持たない関数オブジェクトや束縛引数は入れ子にしても領域を占めない
+  using one = std::integral_constant<int, 1>;
+  using two = std::integral_constant<int, 2>;
+  using three = std::integral_constant<int, 3>;
+  constexpr auto sub = [](int a, auto... bs) { return (a - ... - bs); };
+  constexpr auto f1 = ns::bind_back(sub, one{});
+  constexpr auto f2 = ns::bind_back(f1, two{});
+  constexpr auto f3 = ns::bind_back(f2, three{});
+  static_assert(f3(10) == 10 - 3 - 2 - 1);
+  static_assert(std::is_empty_v<decltype(f3)>);
+  static_assert(sizeof(minus_one) == sizeof(int));
+  static_assert(sizeof(ns::bind_back(f2, 3)) == sizeof(int));
+  static_assert(sizeof(ns::bind_back(ns::bind_back(minus_one, 2), 3)) == 3 * sizeof(int));
 }
@@ -0,0 +1,154 @@
+#!/usr/bin/env bash
+# tuple (tuple.cpp, std::tuple) / bind_back / not_fn / __perfect_forward の
+# 実装ごとに、アリティを変えながら実体化するだけの翻訳単位を生成し、コンパイル時間と最大メモリ使用量を CSV に記録する
+#
+#   ./compile_time_bench.sh [出力ディレクトリ]
+#
+# 環境変数
+#   ARITIES    計測するアリティ (既定: 1 2 4 8 16 32 64 128 256。1..256 すべてなら "$(seq 256)")
+#   COMPILERS  使用するコンパイラ (既定: g++ clang++ のうち見つかったもの)
+#   REPEAT     各点の計測回数。最小値を記録する (既定: 3)
+#
+# 各実装のファイルは main を別名にしてそのまま #include する。
+# そのためヘッダと元の main の分の時間は、アリティ 0 の行として別に記録する
+# clang++ では -ftime-trace の JSON も出力ディレクトリに残す
+set -euo pipefail
+
+here=$(cd "$(dirname "$0")" && pwd)
+out=${1:-compile_time_bench}
+arities=${ARITIES:-1 2 4 8 16 32 64 128 256}
+repeat=${REPEAT:-3}
+compilers=${COMPILERS:-}
+if [[ -z $compilers ]]; then
+  for cxx in g++ clang++; do
+    command -v "$cxx" >/dev/null && compilers+=" $cxx"
+  done
+fi
+
+mkdir -p "$out"
+out=$(cd "$out" && pwd)
+csv=$out/results.csv
+echo "impl,compiler,arity,seconds,max_rss_kb" >"$csv"
+
+declare -A sources=(
+  [tuple]=$here/tuple.cpp
+  [std_tuple]=tuple
+  [bind_back]=$here/bind_back.cpp
+  [not_fn]=$here/not_fn.cpp
+  [perfect_forward]=$here/../509b011bdf9917/perfect_forward.cpp
+)
+
+# 引数 Is... を使って実装を実体化する関数本体
+# 呼び出しは左辺値、const 左辺値、右辺値について行う (tuple.cpp の get は const に対応しないため除く)
+body() {
+  case $1 in
+  tuple)
+    cat <<'EOF'
+  ns::tuple<std::index_sequence<Is...>, tag<Is>...> t{tag<Is>{1}...};
+  return (0 + ... + t.template get<Is>().v) + (0 + ... + std::move(t).template get<Is>().v);
+EOF
+    ;;
+  std_tuple)
+    cat <<'EOF'
+  std::tuple<tag<Is>...> t{tag<Is>{1}...};
+  return (0 + ... + std::get<Is>(t).v) + (0 + ... + std::get<Is>(std::move(t)).v);
+EOF
+    ;;
+  bind_back)
+    cat <<'EOF'
+  auto f = ns::bind_back([](auto&&... ts) { return (0 + ... + ts.v); }, tag<Is>{1}...);
+  return f() + std::as_const(f)() + std::move(f)();
+EOF
+    ;;
+  not_fn)
+    cat <<'EOF'
+  auto f = my_not_fn([](auto&&... ts) { return (0 + ... + ts.v) == 0; });
+  return f(tag<Is>{1}...) + std::as_const(f)(tag<Is>{1}...) + std::move(f)(tag<Is>{1}...);
+EOF
+    ;;
+  perfect_forward)
+    cat <<'EOF'
+  __perfect_forward<sum_op, tag<Is>...> f(tag<Is>{1}...);
+  return f() + std::as_const(f)() + std::move(f)();
+EOF
+    ;;
+  esac
+}
+
+# impl の翻訳単位をアリティ n で生成する。n = 0 ではインクルードのみ
+generate() {
+  local impl=$1 n=$2 tu=$3
+  {
+    # 標準ライブラリのものはヘッダ名で指定する
+    if [[ ${sources[$impl]} == */* ]]; then
+      echo "#define main bench_original_main"
+      echo "#include \"${sources[$impl]}\""
+      echo "#undef main"
+    else
+      echo "#include <${sources[$impl]}>"
+    fi
+    cat <<'EOF'
+#include <cstddef>
+#include <utility>
+
+template <std::size_t I>
+struct tag {
+  int v;
+};
+
+struct sum_op {
+  template <class... Ts>
+  constexpr int operator()(const Ts&... ts) const { return (0 + ... + ts.v); }
+};
+EOF
+    if ((n == 0)); then
+      echo "int main() {}"
+    else
+      echo "template <std::size_t... Is>"
+      echo "int bench(std::index_sequence<Is...>) {"
+      body "$impl"
+      echo "}"
+      echo "int main() { return bench(std::make_index_sequence<$n>{}); }"
+    fi
+  } >"$tu"
+}
+
+# コマンドを実行し、経過時間 [s] と子プロセスの最大 RSS [KiB] を出力する
+measure() {
+  python3 - "$@" <<'EOF'
+import resource, subprocess, sys, time
+t0 = time.perf_counter()
+r = subprocess.run(sys.argv[1:], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+dt = time.perf_counter() - t0
+if r.returncode != 0:
+    sys.stderr.write(r.stderr.decode())
+    sys.exit(r.returncode)
+print(f"{dt:.4f},{resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss}")
+EOF
+}
+
+for cxx in $compilers; do
+  for impl in tuple std_tuple bind_back not_fn perfect_forward; do
+    for n in 0 $arities; do
+      tu=$out/${impl}_$n.cpp
+      generate "$impl" "$n" "$tu"
+      flags=(-std=c++23 -O0 -w -c "$tu" -o "$out/${impl}_${cxx}_$n.o")
+      [[ $cxx == clang* ]] && flags+=(-ftime-trace)
+      best=
+      for ((r = 0; r < repeat; ++r)); do
+        if ! res=$(measure "$cxx" "${flags[@]}"); then
+          echo "$impl: $cxx failed at arity $n" >&2
+          best=
+          break
+        fi
+        if [[ -z $best ]] || python3 -c "import sys; sys.exit(not ${res%,*} < ${best%,*})"; then
+          best=$res
+        fi
+      done
+      [[ -z $best ]] && continue
+      echo "$impl,$cxx,$n,$best" | tee -a "$csv"
+    done
+  done
+done
+rm -f "$out"/*.o
+echo "results: $csv"
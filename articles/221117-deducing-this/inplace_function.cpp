@@ -0,0 +1,310 @@
+// clang-format off
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+// for main
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace ns {
+  // bind_back.cpp より
+  template <class F, class Seq, class... Bound>
+  struct bind_back_t;
+
+  template <class F, std::size_t... I, class... Bound>
+  struct bind_back_t<F, std::index_sequence<I...>, Bound...> {
+    [[no_unique_address]] F f;
+    [[no_unique_address]] std::tuple<Bound...> bound;
+
+    template <class Self, class... Args>
+    constexpr auto operator()(this Self&& self, Args&&... args) noexcept(
+      noexcept(   std::invoke(std::forward_like<Self>(self.f),
+                              std::forward<Args>(args)...,
+                              std::forward_like<Self>(std::get<I>(self.bound))...)))
+      -> decltype(std::invoke(std::forward_like<Self>(self.f),
+                              std::forward<Args>(args)...,
+                              std::forward_like<Self>(std::get<I>(self.bound))...)) {
+      return      std::invoke(std::forward_like<Self>(self.f),
+                              std::forward<Args>(args)...,
+                              std::forward_like<Self>(std::get<I>(self.bound))...);
+    }
+  };
+
+  template <class F, class... Args>
+  requires std::is_constructible_v<std::decay_t<F>, F> and
+           std::is_move_constructible_v<std::decay_t<F>> and
+           (std::is_constructible_v<std::decay_t<Args>, Args> and ...) and
+           (std::is_move_constructible_v<std::decay_t<Args>> and ...)
+  constexpr bind_back_t<std::decay_t<F>,
+                        std::index_sequence_for<Args...>,
+                        std::decay_t<Args>...>
+  bind_back(F&& f, Args&&... args) {
+    return {std::forward<F>(f), {std::forward<Args>(args)...}};
+  }
+
+  // 呼び出し元の値カテゴリ (&, &&, const&, const&&) を 0 ~ 3 の添字にする
+  template <class T>
+  inline constexpr std::size_t __qualifier_index =
+    (std::is_rvalue_reference_v<T&&> ? 1 : 0) + (std::is_const_v<std::remove_reference_t<T>> ? 2 : 0);
+
+  template <class T, class U>
+  using __forward_like_t = decltype(std::forward_like<T>(std::declval<U&>()));
+
+  // __qualifier_index に対応する forward_like の型引数
+  template <std::size_t Q>
+  using __qualifier_t = std::tuple_element_t<Q, std::tuple<int&, int&&, const int&, const int&&>>;
+
+  template <bool Const, bool NoEx, std::size_t Capacity, std::size_t Align, class R, class... Args>
+  class __inplace_function_impl {
+    static_assert(Capacity >= sizeof(void*) and Align >= alignof(void*));
+
+    using __invoker_t = R (*)(void*, Args&&...) noexcept(NoEx);
+
+    // 格納した関数オブジェクトの操作
+    // relocate と destroy が nullptr であれば、ムーブはバッファのコピーのみで済み、破棄は何もしない
+    // 最も多い左辺値からの呼び出しは、間接参照を 1 段減らすため invoke_ にも持つ
+    struct __ops {
+      __invoker_t invoke[4];
+      void (*relocate)(void* dst, void* src) noexcept;
+      void (*destroy)(void*) noexcept;
+    };
+
+    // ムーブ時に例外を投げず、バッファに収まるものはバッファに、それ以外はヒープに置く
+    template <class D>
+    static constexpr bool __stored_inline =
+      sizeof(D) <= Capacity and alignof(D) <= Align and std::is_nothrow_move_constructible_v<D>;
+
+    // trivially copyable なものはバイト列のコピーで移動できる
+    // ヒープに置いたものはポインタを移動すればよいので、常にこちらに含まれる
+    template <class D>
+    static constexpr bool __trivially_relocatable =
+      not __stored_inline<D> or (std::is_trivially_copyable_v<D> and std::is_trivially_destructible_v<D>);
+
+    template <class D>
+    static D& __object(void* p) noexcept {
+      if constexpr (__stored_inline<D>)
+        return *std::launder(static_cast<D*>(p));
+      else
+        return **static_cast<D**>(p);
+    }
+
+    template <class D, std::size_t Q>
+    static R __invoke(void* p, Args&&... args) noexcept(NoEx) {
+      return std::invoke_r<R>(std::forward_like<__qualifier_t<Q>>(__object<D>(p)), std::forward<Args>(args)...);
+    }
+
+    template <class D>
+    static void __relocate(void* dst, void* src) noexcept {
+      D& x = __object<D>(src);
+      ::new (dst) D(std::move(x));
+      x.~D();
+    }
+
+    template <class D>
+    static void __destroy(void* p) noexcept {
+      if constexpr (__stored_inline<D>)
+        __object<D>(p).~D();
+      else
+        delete &__object<D>(p);
+    }
+
+    // const の呼び出しは const のシグネチャの場合にのみ実体化する
+    // (mutable なラムダのように、const では呼べないものも格納できるように)
+    template <class D, std::size_t Q>
+    static constexpr __invoker_t __const_invoker() noexcept {
+      if constexpr (Const)
+        return &__invoke<D, Q>;
+      else
+        return nullptr;
+    }
+
+    template <class D>
+    static constexpr __ops __ops_for{
+      {&__invoke<D, 0>, &__invoke<D, 1>, __const_invoker<D, 2>(), __const_invoker<D, 3>()},
+      __trivially_relocatable<D> ? nullptr : &__relocate<D>,
+      std::is_trivially_destructible_v<D> and __stored_inline<D> ? nullptr : &__destroy<D>,
+    };
+
+    // F を呼び出し元の値カテゴリで呼べること
+    // const のシグネチャであれば、const の場合も呼べること
+    template <class D, class Q>
+    static constexpr bool __callable_as =
+      NoEx ? std::is_nothrow_invocable_r_v<R, __forward_like_t<Q, D>, Args...>
+           : std::is_invocable_r_v<R, __forward_like_t<Q, D>, Args...>;
+
+    alignas(Align) std::byte buf_[Capacity];
+    __invoker_t invoke_ = nullptr;
+    const __ops* ops_ = nullptr;
+
+    void __move_from(__inplace_function_impl& other) noexcept {
+      invoke_ = std::exchange(other.invoke_, nullptr);
+      ops_ = std::exchange(other.ops_, nullptr);
+      if (ops_ and ops_->relocate)
+        ops_->relocate(buf_, other.buf_);
+      else
+        std::memcpy(buf_, other.buf_, Capacity);
+    }
+
+    void __reset() noexcept {
+      if (ops_ and ops_->destroy)
+        ops_->destroy(buf_);
+      invoke_ = nullptr;
+      ops_ = nullptr;
+    }
+
+  public:
+    __inplace_function_impl() noexcept = default;
+    __inplace_function_impl(std::nullptr_t) noexcept {}
+
+    template <class F, class D = std::decay_t<F>>
+    requires (not std::is_base_of_v<__inplace_function_impl, D>) and
+             std::is_constructible_v<D, F> and
+             __callable_as<D, int&> and __callable_as<D, int&&> and
+             (not Const or (__callable_as<D, const int&> and __callable_as<D, const int&&>))
+    __inplace_function_impl(F&& f) : invoke_(&__invoke<D, 0>), ops_(&__ops_for<D>) {
+      if constexpr (__stored_inline<D>)
+        ::new (static_cast<void*>(buf_)) D(std::forward<F>(f));
+      else
+        ::new (static_cast<void*>(buf_)) D*(new D(std::forward<F>(f)));
+    }
+
+    __inplace_function_impl(__inplace_function_impl&& other) noexcept { __move_from(other); }
+    __inplace_function_impl& operator=(__inplace_function_impl&& other) noexcept {
+      if (this != &other) {
+        __reset();
+        __move_from(other);
+      }
+      return *this;
+    }
+    __inplace_function_impl& operator=(std::nullptr_t) noexcept {
+      __reset();
+      return *this;
+    }
+    ~__inplace_function_impl() { __reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+    friend bool operator==(const __inplace_function_impl& f, std::nullptr_t) noexcept { return not f; }
+
+    /// 格納した関数オブジェクトを、*this と同じ値カテゴリで呼び出す
+    /// const でないシグネチャの場合、const な *this からは呼び出せない
+    template <class Self>
+    requires (Const or not std::is_const_v<std::remove_reference_t<Self>>)
+    R operator()(this Self&& self, Args... args) noexcept(NoEx) {
+      assert(self.ops_ != nullptr);
+      void* p = const_cast<std::byte*>(self.buf_);
+      if constexpr (__qualifier_index<Self> == 0)
+        return self.invoke_(p, std::forward<Args>(args)...);
+      else
+        return self.ops_->invoke[__qualifier_index<Self>](p, std::forward<Args>(args)...);
+    }
+  };
+
+  /// 大きさ Capacity までの関数オブジェクトを動的確保なしで格納する move_only_function
+  /// Sig は R(Args...)、R(Args...) const とそれぞれの noexcept 版
+  template <class Sig, std::size_t Capacity = 3 * sizeof(void*), std::size_t Align = alignof(std::max_align_t)>
+  class inplace_function;
+
+  template <class R, class... Args, bool NoEx, std::size_t Capacity, std::size_t Align>
+  class inplace_function<R(Args...) noexcept(NoEx), Capacity, Align>
+    : public __inplace_function_impl<false, NoEx, Capacity, Align, R, Args...> {
+    using __inplace_function_impl<false, NoEx, Capacity, Align, R, Args...>::__inplace_function_impl;
+  };
+
+  template <class R, class... Args, bool NoEx, std::size_t Capacity, std::size_t Align>
+  class inplace_function<R(Args...) const noexcept(NoEx), Capacity, Align>
+    : public __inplace_function_impl<true, NoEx, Capacity, Align, R, Args...> {
+    using __inplace_function_impl<true, NoEx, Capacity, Align, R, Args...>::__inplace_function_impl;
+  };
+} // namespace ns
+
+// 動的確保の回数を数える
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t n) {
+  ++allocations;
+  if (void* p = std::malloc(n))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// キャプチャの大きさが N バイトの関数オブジェクト
+template <std::size_t N>
+struct payload {
+  std::array<char, N> data{};
+  int operator()(int x) const { return x + data[0]; }
+};
+
+int main() {
+  {
+    // 値カテゴリに応じて呼び出す
+    struct qualified {
+      int operator()() & { return 0; }
+      int operator()() && { return 1; }
+      int operator()() const& { return 2; }
+      int operator()() const&& { return 3; }
+    };
+    ns::inplace_function<int() const> f = qualified{};
+    const auto& cf = f;
+    assert(f() == 0 && std::move(f)() == 1 && cf() == 2 && std::move(cf)() == 3);
+    static_assert(not std::is_invocable_v<const ns::inplace_function<int()>&>);
+    static_assert(std::is_nothrow_invocable_v<ns::inplace_function<int() noexcept>&>);
+    static_assert(not std::is_constructible_v<ns::inplace_function<int() noexcept>, int (*)()>);
+
+    // 非 const のシグネチャには、const では呼べないものも格納できる
+    ns::inplace_function<int()> counter = [i = 0]() mutable { return ++i; };
+    assert(counter() == 1 && counter() == 2 && std::move(counter)() == 3);
+
+    // bind_back_t を格納する
+    ns::inplace_function<int(int)> minus_one = ns::bind_back(std::minus{}, 1);
+    assert(minus_one(42) == 41);
+
+    // 大きなものや、ムーブで例外を投げうるものはヒープに置く
+    allocations = 0;
+    ns::inplace_function<std::size_t(), 16> big = [s = std::string(100, 'x')] { return s.size(); };
+    assert(big() == 100 && allocations == 2);
+    auto moved = std::move(big);
+    assert(moved() == 100 && not big && allocations == 2);
+    moved = nullptr;
+    assert(moved == nullptr);
+  }
+
+  // 計測: 関数オブジェクトの大きさごとの動的確保の回数と呼び出しの時間
+  constexpr std::size_t n = 1 << 16, reps = 256;
+  std::printf("size\tstd::function [alloc/obj]\tinplace [alloc/obj]\tstd::function [ns/call]\tinplace [ns/call]\n");
+  auto run = []<std::size_t N>(std::integral_constant<std::size_t, N>) {
+    auto measure = [&]<class Fn>(std::type_identity<Fn>) {
+      std::vector<Fn> fs;
+      fs.reserve(n);
+      allocations = 0;
+      for (std::size_t i = 0; i < n; ++i)
+        fs.emplace_back(payload<N>{});
+      const double allocs = static_cast<double>(allocations) / n;
+      long long sum = 0;
+      const auto t0 = std::chrono::steady_clock::now();
+      for (std::size_t r = 0; r < reps; ++r)
+        for (auto& f : fs)
+          sum += f(static_cast<int>(r));
+      const std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+      return std::tuple(allocs, dt.count() / (n * reps), sum);
+    };
+    const auto [a_std, t_std, s_std] = measure(std::type_identity<std::function<int(int)>>{});
+    const auto [a_inp, t_inp, s_inp] = measure(std::type_identity<ns::inplace_function<int(int) const, 64>>{});
+    assert(s_std == s_inp);
+    std::printf("%zu\t%g\t%g\t%.2f\t%.2f\n", N, a_std, a_inp, t_std, t_inp);
+  };
+  [&]<std::size_t... Ns>(std::index_sequence<Ns...>) {
+    (run(std::integral_constant<std::size_t, Ns>{}), ...);
+  }(std::index_sequence<8, 16, 24, 32, 48, 64>{});
+}
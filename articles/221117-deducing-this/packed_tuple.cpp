@@ -0,0 +1,149 @@
+// clang-format off
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+// for main
+#include <cassert>
+#include <iostream>
+#include <string>
+
+namespace ns {
+  // tuple_with_ic.cpp より
+  template <char... Chars>
+  constexpr std::size_t parse_ic() {
+    const char cs[]{Chars...};
+    std::size_t n{};
+    auto [ptr, ec] = std::from_chars(std::begin(cs), std::end(cs), n);
+    return ptr == std::end(cs) && ec == std::errc{} ? n : throw std::logic_error("");
+  }
+
+  template <char... Chars>
+  constexpr auto operator""_ic() {
+    return std::integral_constant<std::size_t, parse_ic<Chars...>()>{};
+  }
+
+  // 空の型は [[no_unique_address]] によって領域を占めない
+  template <std::size_t I, class T>
+  struct tuple_leaf {
+    [[no_unique_address]] T value;
+  };
+
+  template <std::size_t I, class T>
+  tuple_leaf<I, T> at_index(const tuple_leaf<I, T>&); // undefined
+
+  // 比較対象: 宣言順に tuple_leaf を継承する tuple (tuple_with_ic.cpp と同じ)
+  template <class Seq, class... Ts>
+  struct tuple;
+
+  template <std::size_t... Is, class... Ts>
+  struct tuple<std::index_sequence<Is...>, Ts...> : tuple_leaf<Is, Ts>... {
+    template <std::size_t I, class Self>
+    requires (I < sizeof...(Ts))
+    constexpr decltype(auto) operator[](this Self&& self, std::integral_constant<std::size_t, I>) {
+      using leaf = decltype(at_index<I>(self));
+      return std::forward_like<Self>(static_cast<leaf&>(self).value);
+    }
+  };
+
+  template <class... Ts>
+  tuple(Ts...) -> tuple<std::index_sequence_for<Ts...>, Ts...>;
+
+  // 論理的な添字 (宣言順) と物理的な添字 (配置順) の対応
+  // アライメントの大きい順に並べ、空の型は最後に置く。同じ順位のものは宣言順
+  // 各要素の大きさはアライメントの倍数なので、こう並べると要素間に詰め物が入らない
+  template <class... Ts>
+  struct packed_layout {
+    static constexpr std::size_t size = sizeof...(Ts);
+
+    static constexpr std::array<std::size_t, size> physical = [] {
+      constexpr std::array<std::size_t, size> key{(std::is_empty_v<Ts> ? 0 : alignof(Ts))...};
+      std::array<std::size_t, size> p{};
+      for (std::size_t i = 0; i < size; ++i)
+        for (std::size_t j = 0; j < size; ++j)
+          p[i] += key[j] > key[i] || (key[j] == key[i] && j < i);
+      return p;
+    }();
+
+    static constexpr std::array<std::size_t, size> logical = [] {
+      std::array<std::size_t, size> l{};
+      for (std::size_t i = 0; i < size; ++i)
+        l[physical[i]] = i;
+      return l;
+    }();
+  };
+
+  // 物理的に K 番目に置く tuple_leaf。添字は論理的な添字のまま持たせる
+  template <std::size_t K, class... Ts>
+  using packed_leaf_t = tuple_leaf<packed_layout<Ts...>::logical[K],
+                                   std::tuple_element_t<packed_layout<Ts...>::logical[K], std::tuple<Ts...>>>;
+
+  /// 詰め物が最小となるよう要素を並べ替えて格納する tuple
+  /// get<I>() と operator[](I_ic) は論理的な添字で要素を指す
+  template <class Seq, class... Ts>
+  struct packed_tuple;
+
+  template <std::size_t... Ks, class... Ts>
+  struct packed_tuple<std::index_sequence<Ks...>, Ts...> : packed_leaf_t<Ks, Ts...>... {
+    using layout = packed_layout<Ts...>;
+
+    constexpr packed_tuple() = default;
+
+    template <class... Us>
+    requires (sizeof...(Us) == sizeof...(Ts)) && (std::is_constructible_v<Ts, Us&&> && ...)
+    constexpr packed_tuple(Us&&... xs)
+      : packed_leaf_t<Ks, Ts...>{
+          std::get<layout::logical[Ks]>(std::forward_as_tuple(std::forward<Us>(xs)...))}... {}
+
+    template <std::size_t I, class Self>
+    requires (I < sizeof...(Ts))
+    constexpr decltype(auto) get(this Self&& self) {
+      using leaf = decltype(at_index<I>(self));
+      return std::forward_like<Self>(self.leaf::value);
+    }
+
+    template <std::size_t I, class Self>
+    requires (I < sizeof...(Ts))
+    constexpr decltype(auto) operator[](this Self&& self, std::integral_constant<std::size_t, I>) {
+      return std::forward<Self>(self).template get<I>();
+    }
+  };
+
+  template <class... Ts>
+  packed_tuple(Ts...) -> packed_tuple<std::index_sequence_for<Ts...>, Ts...>;
+} // namespace ns
+
+struct empty {};
+
+int main() {
+  using ns::operator""_ic;
+
+  // 宣言順では char, (7), double, char, (3), int となり 24 バイト
+  // 並べ替えると double, int, char, char, (2) となり 16 バイト
+  using plain = ns::tuple<std::index_sequence<0, 1, 2, 3>, char, double, char, int>;
+  using packed = ns::packed_tuple<std::index_sequence<0, 1, 2, 3>, char, double, char, int>;
+  static_assert(sizeof(plain) == 24);
+  static_assert(sizeof(packed) == 16);
+  static_assert(packed::layout::physical == std::array<std::size_t, 4>{2, 0, 3, 1});
+  static_assert(std::is_trivially_copyable_v<packed>);
+
+  // 空の型は領域を占めない
+  using with_empty = ns::packed_tuple<std::index_sequence<0, 1, 2>, empty, int, char>;
+  static_assert(sizeof(with_empty) == 8);
+
+  constexpr ns::packed_tuple c{'a', 2.5, 'b', 42};
+  static_assert(c.get<0>() == 'a' && c.get<1>() == 2.5);
+  static_assert(c[2_ic] == 'b' && c[3_ic] == 42);
+
+  ns::packed_tuple t{1, 'x', 3.14, std::string("hello")};
+  t[1_ic] = 'y';
+  assert(t.get<0>() == 1 && t.get<1>() == 'y' && t[2_ic] == 3.14);
+  std::string s = std::move(t)[3_ic]; // 右辺値からはムーブされる
+  assert(s == "hello");
+
+  std::cout << "sizeof(tuple<char, double, char, int>): " << sizeof(plain) << "\n"
+            << "sizeof(packed_tuple<char, double, char, int>): " << sizeof(packed) << std::endl;
+}
@@ -0,0 +1,254 @@
+// clang-format off
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// for main
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace ns {
+  // tuple.cpp, tuple_with_ic.cpp より
+  template <char... Chars>
+  constexpr std::size_t parse_ic() {
+    const char cs[]{Chars...};
+    std::size_t n{};
+    auto [ptr, ec] = std::from_chars(std::begin(cs), std::end(cs), n);
+    return ptr == std::end(cs) && ec == std::errc{} ? n : throw std::logic_error("");
+  }
+
+  template <char... Chars>
+  constexpr auto operator""_ic() {
+    return std::integral_constant<std::size_t, parse_ic<Chars...>()>{};
+  }
+
+  template <std::size_t I, class T>
+  struct tuple_leaf {
+    T value;
+  };
+
+  template <std::size_t I, class T>
+  tuple_leaf<I, T> at_index(const tuple_leaf<I, T>&); // undefined
+
+  template <class Seq, class... Ts>
+  struct tuple;
+
+  template <std::size_t... Is, class... Ts>
+  struct tuple<std::index_sequence<Is...>, Ts...> : tuple_leaf<Is, Ts>... {
+    template <std::size_t I, class Self>
+    requires (I < sizeof...(Ts))
+    constexpr decltype(auto) get(this Self&& self) {
+      using leaf = decltype(at_index<I>(self));
+      return std::forward_like<Self>(self.leaf::value);
+    }
+
+    template <std::size_t I, class Self>
+    requires (I < sizeof...(Ts))
+    constexpr decltype(auto) operator[](this Self&& self, std::integral_constant<std::size_t, I>) {
+      return std::forward<Self>(self).template get<I>();
+    }
+  };
+
+  template <class... Ts>
+  tuple(Ts...) -> tuple<std::index_sequence_for<Ts...>, Ts...>;
+
+  /// soa_vector の要素への参照
+  /// Vec は soa_vector または const soa_vector であり、get<I>() は I 番目の列の要素を指す
+  template <class Vec>
+  struct soa_reference {
+    Vec* vec;
+    std::size_t index;
+
+    template <std::size_t I>
+    constexpr auto& get() const {
+      return vec->template column<I>()[index];
+    }
+
+    template <std::size_t I>
+    constexpr auto& operator[](std::integral_constant<std::size_t, I>) const {
+      return get<I>();
+    }
+  };
+
+  template <class Seq, class... Ts>
+  struct soa_vector_impl;
+
+  /// tuple<Ts...> の列を、要素の型ごとに別々の連続した配列として格納する
+  /// 1 つのフィールドだけを走査する場合に、他のフィールドをキャッシュに載せずに済む
+  template <std::size_t... Is, class... Ts>
+  struct soa_vector_impl<std::index_sequence<Is...>, Ts...> {
+    using value_type = tuple<std::index_sequence<Is...>, Ts...>;
+    using reference = soa_reference<soa_vector_impl>;
+    using const_reference = soa_reference<const soa_vector_impl>;
+
+  private:
+    // 各列を tuple_leaf として持つ
+    tuple<std::index_sequence<Is...>, std::vector<Ts>...> columns_;
+
+  public:
+    constexpr std::size_t size() const noexcept { return columns_.template get<0>().size(); }
+    constexpr bool empty() const noexcept { return size() == 0; }
+
+    constexpr void reserve(std::size_t n) {
+      (columns_.template get<Is>().reserve(n), ...);
+    }
+
+    /// 要素の構築が例外を送出した場合、構築済みの列からも取り除き、すべての列の長さを揃えたままにする
+    /// xs は自身の要素を参照していてもよい (std::vector::emplace_back と同様)
+    template <class... Us>
+    requires (sizeof...(Us) == sizeof...(Ts)) && (std::is_constructible_v<Ts, Us&&> && ...)
+    constexpr reference emplace_back(Us&&... xs) {
+      // 列の再確保で xs が無効にならないよう、先に新しい要素を構築する
+      value_type x{{Ts(std::forward<Us>(xs))}...};
+      // すべての列の容量を確保し、列の途中で確保に失敗しないようにする
+      if (const std::size_t n = size(); ((columns_.template get<Is>().capacity() == n) || ...))
+        reserve(std::max<std::size_t>(2 * n, 1));
+      std::size_t done = 0;
+      try {
+        ((columns_.template get<Is>().push_back(std::move(x).template get<Is>()), ++done), ...);
+      } catch (...) {
+        ((Is < done ? columns_.template get<Is>().pop_back() : void()), ...);
+        throw;
+      }
+      return (*this)[size() - 1];
+    }
+
+    constexpr reference push_back(const value_type& x) {
+      return emplace_back(x.template get<Is>()...);
+    }
+    constexpr reference push_back(value_type&& x) {
+      return emplace_back(std::move(x).template get<Is>()...);
+    }
+
+    template <class Self>
+    constexpr auto operator[](this Self& self, std::size_t i) {
+      return soa_reference<Self>{&self, i};
+    }
+
+    /// I 番目の列全体
+    template <std::size_t I, class Self>
+    requires (I < sizeof...(Ts))
+    constexpr auto column(this Self& self) {
+      return std::span(self.columns_.template get<I>());
+    }
+
+    template <std::size_t I, class Self>
+    requires (I < sizeof...(Ts))
+    constexpr auto column(this Self& self, std::integral_constant<std::size_t, I>) {
+      return self.template column<I>();
+    }
+  };
+
+  template <class... Ts>
+  using soa_vector = soa_vector_impl<std::index_sequence_for<Ts...>, Ts...>;
+} // namespace ns
+
+int main() {
+  using ns::operator""_ic;
+  {
+    ns::soa_vector<int, double, char> v;
+    v.emplace_back(1, 3.14, 'a');
+    v.push_back(ns::tuple{2, 2.71, 'b'});
+    assert(v.size() == 2);
+    assert(v[0].get<0>() == 1 && v[0][1_ic] == 3.14 && v[1][2_ic] == 'b');
+    v[1][0_ic] = 42;
+    assert(v.column<0>()[1] == 42);
+    const auto& cv = v;
+    static_assert(std::is_same_v<decltype(cv[0].get<0>()), const int&>);
+    static_assert(std::is_same_v<decltype(cv.column(1_ic)), std::span<const double>>);
+  }
+  {
+    // 途中の列で構築が失敗しても、列の長さは揃ったままになる
+    struct throwing {
+      throwing(int x) { if (x < 0) throw std::runtime_error("negative"); }
+    };
+    ns::soa_vector<int, throwing, double> v;
+    v.emplace_back(1, 1, 1.0);
+    try {
+      v.emplace_back(2, -1, 2.0);
+      assert(false);
+    } catch (const std::runtime_error&) {
+    }
+    assert(v.size() == 1 && v.column<0>().size() == 1 && v.column<1>().size() == 1 && v.column<2>().size() == 1);
+    v.emplace_back(3, 3, 3.0);
+    assert(v.size() == 2 && v[1].get<0>() == 3 && v[1][2_ic] == 3.0);
+  }
+  {
+    // 容量が尽きた状態で、自身の要素を引数にとる
+    ns::soa_vector<std::string, std::string> v;
+    v.emplace_back(std::string(32, 'a'), std::string(32, 'b'));
+    for (int i = 0; i < 4; ++i) {
+      assert(v.column<0>().size() == v.size());
+      v.emplace_back(v[0].get<1>(), v[i].get<0>());
+    }
+    assert(v.size() == 5 && v[4].get<0>() == std::string(32, 'b') && v[4].get<1>() == std::string(32, 'b'));
+    assert(v[1].get<1>() == std::string(32, 'a'));
+  }
+
+  // 計測: 1 つのフィールドだけを走査する場合の AoS と SoA の比較
+  // レコードは 24 バイトで、走査するのは 8 バイトのフィールド 1 つだけ
+  using record = ns::tuple<std::index_sequence<0, 1, 2, 3>, double, std::int64_t, std::int32_t, std::int32_t>;
+  constexpr std::size_t n = 10'000'000;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> price(0, 100);
+  std::vector<record> aos;
+  ns::soa_vector<double, std::int64_t, std::int32_t, std::int32_t> soa;
+  aos.reserve(n);
+  soa.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    record r{price(gen), static_cast<std::int64_t>(i), static_cast<std::int32_t>(gen() % 100), 0};
+    aos.push_back(r);
+    soa.push_back(r);
+  }
+
+  // 5 回計測して最小値をとる
+  auto best_of = [](auto f) {
+    double best = 1e300, result = 0;
+    for (int rep = 0; rep < 5; ++rep) {
+      const auto t0 = std::chrono::steady_clock::now();
+      result = f();
+      const std::chrono::duration<double, std::milli> dt = std::chrono::steady_clock::now() - t0;
+      best = std::min(best, dt.count());
+    }
+    return std::pair(best, result);
+  };
+  const auto [t_aos, s_aos] = best_of([&] {
+    double sum = 0;
+    for (const auto& r : aos)
+      sum += r[0_ic];
+    return sum;
+  });
+  const auto [t_soa, s_soa] = best_of([&] {
+    double sum = 0;
+    for (double x : soa.column(0_ic))
+      sum += x;
+    return sum;
+  });
+  assert(s_aos == s_soa);
+  // 2 つのフィールドを使う場合
+  const auto [t_aos2, s_aos2] = best_of([&] {
+    double sum = 0;
+    for (const auto& r : aos)
+      sum += r[0_ic] * r[2_ic];
+    return sum;
+  });
+  const auto [t_soa2, s_soa2] = best_of([&] {
+    const auto prices = soa.column(0_ic);
+    const auto qty = soa.column(2_ic);
+    double sum = 0;
+    for (std::size_t i = 0; i < prices.size(); ++i)
+      sum += prices[i] * qty[i];
+    return sum;
+  });
+  assert(s_aos2 == s_soa2);
+  std::cout << "sum of 1 field:  AoS " << t_aos << " ms, SoA " << t_soa << " ms\n"
+            << "sum of 2 fields: AoS " << t_aos2 << " ms, SoA " << t_soa2 << " ms" << std::endl;
+}
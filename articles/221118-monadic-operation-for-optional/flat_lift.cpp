@@ -0,0 +1,167 @@
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+// for main
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ns {
+  template <class T>
+  inline constexpr bool is_optional_v = false;
+  template <class T>
+  inline constexpr bool is_optional_v<std::optional<T>> = true;
+
+  template <class T>
+  concept optional_ = is_optional_v<std::remove_cvref_t<T>>;
+
+  // optional_apply_lift.cpp より: 部分適用したクロージャを optional に包んで
+  // 1 引数ずつ適用するため、N 引数では N - 1 個の中間の optional を生成する
+  // fn はカリー化されていなければならない
+  template <optional_ F, optional_ O>
+  constexpr auto apply(F&& f, O&& o)
+    -> decltype(std::forward<O>(o).transform(*std::forward<F>(f))) {
+    if (f)
+      return std::forward<O>(o).transform(*std::forward<F>(f));
+    else
+      return std::nullopt;
+  }
+
+  template <std::size_t... Is, class... Args>
+  constexpr auto lift_impl(std::index_sequence<Is...>, Args&&... args) {
+    auto t = std::forward_as_tuple(std::forward<Args>(args)...);
+    if constexpr (sizeof...(Args) == 2)
+      return std::get<1>(std::move(t)).transform(std::get<0>(std::move(t)));
+    else
+      return apply(
+        lift_impl(std::make_index_sequence<sizeof...(Is) - 1>{},
+                  std::get<Is>(std::move(t))...),
+        std::get<sizeof...(Is)>(std::move(t)));
+  }
+
+  template <class... Args>
+  requires (sizeof...(Args) > 1)
+  constexpr auto nested_lift(Args&&... args) {
+    return lift_impl(std::make_index_sequence<sizeof...(Args) - 1>{},
+                     std::forward<Args>(args)...);
+  }
+
+  // nested_lift に渡すために N 引数の関数をカリー化する
+  template <std::size_t N, class F>
+  constexpr auto curry(F f) {
+    if constexpr (N <= 1)
+      return f;
+    else
+      return [f](auto x) {
+        return curry<N - 1>(
+          [f, x](auto&&... rest) { return std::invoke(f, x, rest...); });
+      };
+  }
+
+  /// すべての引数が有効値を持つ場合に限り、fn をその値で呼び出す
+  /// 有効性は 1 度にまとめて検査し、中間の optional やクロージャを生成しない
+  template <class F, optional_... Os>
+  requires (sizeof...(Os) > 0)
+           and std::invocable<F&&, decltype(*std::declval<Os&&>())...>
+  constexpr auto lift(F&& fn, Os&&... os) -> std::optional<std::remove_cvref_t<
+    std::invoke_result_t<F&&, decltype(*std::declval<Os&&>())...>>> {
+    // && ではなく & で畳み込み、分岐を 1 つにする
+    if ((static_cast<bool>(os) & ...))
+      return std::invoke(std::forward<F>(fn), *std::forward<Os>(os)...);
+    else
+      return std::nullopt;
+  }
+} // namespace ns
+
+#ifdef LIFT_COMPILE_BENCH
+// コンパイル時間の計測: 引数の型をすべて異なるものにし、
+// アリティ 1 ~ LIFT_COMPILE_BENCH の lift をそれぞれ実体化する
+//   g++ -std=c++23 -fsyntax-only -DLIFT_COMPILE_BENCH=16 flat_lift.cpp
+// -DLIFT_NESTED を加えると nested_lift を実体化する
+template <std::size_t N, std::size_t I>
+struct tag {
+  int value;
+};
+
+template <std::size_t N, std::size_t... Is>
+int instantiate(std::index_sequence<Is...>) {
+  auto fn = [](auto... xs) { return (0 + ... + xs.value); };
+#ifdef LIFT_NESTED
+  return ns::nested_lift(ns::curry<N>(fn), std::optional(tag<N, Is>{1})...)
+    .value_or(0);
+#else
+  return ns::lift(fn, std::optional(tag<N, Is>{1})...).value_or(0);
+#endif
+}
+
+template <std::size_t... Ns>
+int instantiate_all(std::index_sequence<Ns...>) {
+  return (0 + ... + instantiate<Ns + 1>(std::make_index_sequence<Ns + 1>{}));
+}
+
+int main() {
+  return instantiate_all(std::make_index_sequence<LIFT_COMPILE_BENCH>{});
+}
+#else
+// 実行時間の計測: アリティ N の lift を rows 行に対して繰り返し呼び出す
+template <std::size_t N>
+void run_bench(std::mt19937& gen) {
+  constexpr std::size_t rows = 1 << 12, reps = 1 << 10;
+  std::bernoulli_distribution engaged(0.99);
+  std::vector<std::array<std::optional<int>, N>> data(rows);
+  for (auto& row : data)
+    for (auto& o : row)
+      o = engaged(gen) ? std::optional(static_cast<int>(gen() % 100))
+                       : std::nullopt;
+
+  auto fn = [](auto... xs) { return (0 + ... + xs); };
+  auto measure = [&](auto call) {
+    long long sum = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < reps; ++r)
+      for (const auto& row : data)
+        sum += std::apply(call, row).value_or(0);
+    const std::chrono::duration<double, std::nano> dt =
+      std::chrono::steady_clock::now() - t0;
+    return std::pair(dt.count() / (rows * reps), sum);
+  };
+  const auto [t_nested, s_nested] = measure([&](const auto&... os) {
+    return ns::nested_lift(ns::curry<N>(fn), os...);
+  });
+  const auto [t_flat, s_flat] =
+    measure([&](const auto&... os) { return ns::lift(fn, os...); });
+  assert(s_nested == s_flat);
+  std::cout << N << "\t" << t_nested << "\t" << t_flat << "\n";
+}
+
+int main() {
+  {
+    std::optional o1(1);
+    std::optional o2(3.14);
+    std::optional o3(std::string("hello"));
+    auto fn = [](int i, double d, const std::string& s) {
+      return std::to_string(i) + ", " + std::to_string(d) + ", " + s;
+    };
+    assert(ns::lift(fn, o1, o2, o3) == "1, 3.140000, hello");
+    assert(ns::lift(fn, o1, std::optional<double>(), o3) == std::nullopt);
+    assert(ns::nested_lift(ns::curry<3>(fn), o1, o2, o3)
+           == ns::lift(fn, o1, o2, o3));
+    // 右辺値の optional からは値がムーブされる
+    auto take = [](std::string&& s) { return std::move(s); };
+    assert(ns::lift(take, std::move(o3)) == "hello");
+  }
+
+  std::mt19937 gen(42);
+  std::cout << "arity\tnested [ns/call]\tflat [ns/call]\n";
+  [&]<std::size_t... Ns>(std::index_sequence<Ns...>) {
+    (run_bench<Ns + 1>(gen), ...);
+  }(std::make_index_sequence<16>{});
+}
+#endif
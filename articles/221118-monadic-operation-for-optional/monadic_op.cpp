@@ -1,15 +1,21 @@
+#include <bit>
 #include <cassert>
 #include <compare>
 #include <concepts>
+#include <cstdint>
+#include <expected>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <ranges>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 // for test
 #include <cmath>
 #include <stdexcept>
+#include <string>
 
 namespace ns {
   template <class T, class U>
@@ -23,9 +29,162 @@ namespace ns {
   template <class T>
   inline constexpr bool __is_optional_v<optional<T>> = true;
 
+  /// T の値のうち、無効値として optional の無効状態を表すものを与える
+  /// 特殊化は次の静的メンバ関数を持つ
+  /// - T invalid():                 無効値
+  /// - bool is_invalid(const T& x): x が無効値であるか
+  /// - T canonicalize(T x):         (省略可) 無効値と同じ表現の値を別の値に置き換える
   template <class T>
-  struct optional : std::optional<T> {
-    using std::optional<T>::optional;
+  struct niche_traits {};
+
+  template <class T>
+  concept __has_niche = requires(const T& x) {
+    { niche_traits<T>::invalid() } -> std::same_as<T>;
+    { niche_traits<T>::is_invalid(x) } -> std::same_as<bool>;
+  };
+
+  /// 列挙型や ID 型の無効値を宣言するための基底
+  /// template <>
+  /// struct ns::niche_traits<color> : ns::sentinel_niche<color, color(-1)> {};
+  template <class T, T Invalid>
+  struct sentinel_niche {
+    static constexpr T invalid() noexcept { return Invalid; }
+    static constexpr bool is_invalid(const T& x) noexcept {
+      return x == Invalid;
+    }
+  };
+
+  // ポインタ: 整列されておらず、指すことのできないアドレス
+  // reinterpret_cast を用いるため、無効状態は定数式で扱えない
+  template <class T>
+  struct niche_traits<T*> {
+    static T* invalid() noexcept {
+      return reinterpret_cast<T*>(~std::uintptr_t{0});
+    }
+    static bool is_invalid(T* p) noexcept {
+      return reinterpret_cast<std::uintptr_t>(p) == ~std::uintptr_t{0};
+    }
+  };
+
+  // 浮動小数点数: 演算では生成されないペイロードを持つ静止 NaN (NaN-boxing)
+  template <std::floating_point T>
+  requires std::numeric_limits<T>::is_iec559
+           and (sizeof(T) == sizeof(std::uint32_t)
+                or sizeof(T) == sizeof(std::uint64_t))
+  struct niche_traits<T> {
+  private:
+    using bits = std::conditional_t<sizeof(T) == sizeof(std::uint32_t),
+                                    std::uint32_t, std::uint64_t>;
+    static constexpr bits pattern = sizeof(T) == sizeof(std::uint32_t)
+                                      ? bits{0x7FC0'DEAD}
+                                      : bits{0x7FF8'0000'DEAD'BEEF};
+
+  public:
+    static constexpr T invalid() noexcept { return std::bit_cast<T>(pattern); }
+    static constexpr bool is_invalid(const T& x) noexcept {
+      return std::bit_cast<bits>(x) == pattern;
+    }
+    // 同じペイロードを持つ NaN は標準の NaN として格納する
+    static constexpr T canonicalize(T x) noexcept {
+      return is_invalid(x) ? std::numeric_limits<T>::quiet_NaN() : x;
+    }
+  };
+
+  /// 有効性のフラグを持たず、無効状態を T の無効値で表す optional
+  template <class T>
+  struct __niche_optional {
+    using value_type = T;
+
+  private:
+    using __traits = niche_traits<T>;
+    T val_ = __traits::invalid();
+
+    static constexpr T __store(T x) noexcept {
+      if constexpr (requires { __traits::canonicalize(std::move(x)); })
+        return __traits::canonicalize(std::move(x));
+      else {
+        assert(not __traits::is_invalid(x));
+        return x;
+      }
+    }
+
+  public:
+    constexpr __niche_optional() noexcept = default;
+    constexpr __niche_optional(std::nullopt_t) noexcept {}
+    template <class U = T>
+    requires std::constructible_from<T, U&&>
+             and (not std::same_as<std::remove_cvref_t<U>, std::in_place_t>)
+             and (not std::same_as<std::remove_cvref_t<U>, std::nullopt_t>)
+             and (not std::same_as<std::remove_cvref_t<U>, __niche_optional>)
+             and (not __is_optional_v<std::remove_cvref_t<U>>)
+    constexpr explicit(not std::is_convertible_v<U&&, T>)
+      __niche_optional(U&& x)
+      : val_(__store(T(std::forward<U>(x)))) {}
+    template <class... Args>
+    requires std::constructible_from<T, Args&&...>
+    constexpr explicit __niche_optional(std::in_place_t, Args&&... args)
+      : val_(__store(T(std::forward<Args>(args)...))) {}
+
+    constexpr bool has_value() const noexcept {
+      return not __traits::is_invalid(val_);
+    }
+    constexpr explicit operator bool() const noexcept { return has_value(); }
+
+    template <class Self>
+    constexpr auto&& operator*(this Self&& self) noexcept {
+      return std::forward_like<Self>(self.val_);
+    }
+    constexpr const T* operator->() const noexcept { return &val_; }
+    constexpr T* operator->() noexcept { return &val_; }
+
+    template <class Self>
+    constexpr auto&& value(this Self&& self) {
+      if (not self.has_value())
+        throw std::bad_optional_access();
+      return std::forward_like<Self>(self.val_);
+    }
+    template <class Self, class U>
+    constexpr T value_or(this Self&& self, U&& u) {
+      if (self.has_value())
+        return std::forward_like<Self>(self.val_);
+      else
+        return static_cast<T>(std::forward<U>(u));
+    }
+
+    template <class... Args>
+    constexpr T& emplace(Args&&... args) {
+      val_ = __store(T(std::forward<Args>(args)...));
+      return val_;
+    }
+    constexpr void reset() noexcept { val_ = __traits::invalid(); }
+    constexpr void swap(__niche_optional& other) noexcept {
+      std::ranges::swap(val_, other.val_);
+    }
+
+    // std::optional と同じく、無効状態は有効な値より小さい
+    friend constexpr bool operator==(const __niche_optional& x,
+                                     const __niche_optional& y) {
+      if (x.has_value() and y.has_value())
+        return x.val_ == y.val_;
+      return x.has_value() == y.has_value();
+    }
+    friend constexpr std::compare_three_way_result_t<T>
+    operator<=>(const __niche_optional& x, const __niche_optional& y) {
+      if (x.has_value() and y.has_value())
+        return x.val_ <=> y.val_;
+      return x.has_value() <=> y.has_value();
+    }
+  };
+
+  template <class T>
+  using __optional_base =
+    std::conditional_t<__has_niche<T>, __niche_optional<T>, std::optional<T>>;
+
+  /// niche_traits<T> が特殊化されている場合は、T の無効値で無効状態を表す
+  template <class T>
+  struct optional : __optional_base<T> {
+    using __base = __optional_base<T>;
+    using __base::__base;
 
     friend constexpr auto operator<=>(const optional&,
                                       const optional&) = default;
@@ -74,8 +233,215 @@ namespace ns {
   constexpr auto operator<=>(const optional<T>& x, std::nullopt_t) {
     return x.has_value() <=> false;
   }
+
+  template <class T, class E>
+  struct expected;
+
+  template <class T>
+  inline constexpr bool __is_expected_v = false;
+  template <class T, class E>
+  inline constexpr bool __is_expected_v<expected<T, E>> = true;
+
+  /// 失敗の理由 E を保持する optional
+  /// T と E が trivially copyable で小さい場合、expected<T, E> は
+  /// レジスタで返される
+  template <class T, class E>
+  struct expected : std::expected<T, E> {
+    using std::expected<T, E>::expected;
+
+    template <class Self, std::invocable<__forward_like_t<Self, T>> F>
+    constexpr auto transform(this Self&& self, F&& f)
+      -> expected<std::remove_cvref_t<
+                    std::invoke_result_t<F&&, __forward_like_t<Self, T>>>,
+                  E> {
+      if (self)
+        return std::invoke(std::forward<F>(f), std::forward_like<Self>(*self));
+      else
+        return std::unexpected(std::forward_like<Self>(self.error()));
+    }
+
+    template <class Self, std::invocable<__forward_like_t<Self, T>> F>
+    requires __is_expected_v<
+      std::remove_cvref_t<std::invoke_result_t<F&&, __forward_like_t<Self, T>>>>
+    constexpr auto and_then(this Self&& self, F&& f) -> std::remove_cvref_t<
+      std::invoke_result_t<F&&, __forward_like_t<Self, T>>> {
+      if (self)
+        return std::invoke(std::forward<F>(f), std::forward_like<Self>(*self));
+      else
+        return std::unexpected(std::forward_like<Self>(self.error()));
+    }
+
+    template <class Self, std::invocable<__forward_like_t<Self, E>> F>
+    requires __is_expected_v<
+      std::remove_cvref_t<std::invoke_result_t<F&&, __forward_like_t<Self, E>>>>
+    constexpr auto or_else(this Self&& self, F&& f) -> std::remove_cvref_t<
+      std::invoke_result_t<F&&, __forward_like_t<Self, E>>> {
+      using R = std::remove_cvref_t<
+        std::invoke_result_t<F&&, __forward_like_t<Self, E>>>;
+      if (self)
+        return R(std::in_place, std::forward_like<Self>(*self));
+      else
+        return std::invoke(std::forward<F>(f),
+                           std::forward_like<Self>(self.error()));
+    }
+
+    template <class Self, std::invocable<__forward_like_t<Self, E>> F>
+    constexpr auto transform_error(this Self&& self, F&& f)
+      -> expected<T, std::remove_cvref_t<
+                       std::invoke_result_t<F&&, __forward_like_t<Self, E>>>> {
+      using R = expected<T, std::remove_cvref_t<std::invoke_result_t<
+                              F&&, __forward_like_t<Self, E>>>>;
+      if (self)
+        return R(std::in_place, std::forward_like<Self>(*self));
+      else
+        return R(std::unexpect, std::invoke(std::forward<F>(f),
+                                            std::forward_like<Self>(
+                                              self.error())));
+    }
+  };
+
+  // bind_back.cpp より
+  template <class F, class Seq, class... Bound>
+  struct bind_back_t;
+
+  template <class F, std::size_t... I, class... Bound>
+  struct bind_back_t<F, std::index_sequence<I...>, Bound...> {
+    [[no_unique_address]] F f;
+    [[no_unique_address]] std::tuple<Bound...> bound;
+
+    template <class Self, class... Args>
+    constexpr auto operator()(this Self&& self, Args&&... args) noexcept(
+      noexcept(std::invoke(std::forward_like<Self>(self.f),
+                           std::forward<Args>(args)...,
+                           std::forward_like<Self>(std::get<I>(self.bound))...)))
+      -> decltype(std::invoke(
+        std::forward_like<Self>(self.f), std::forward<Args>(args)...,
+        std::forward_like<Self>(std::get<I>(self.bound))...)) {
+      return std::invoke(std::forward_like<Self>(self.f),
+                         std::forward<Args>(args)...,
+                         std::forward_like<Self>(std::get<I>(self.bound))...);
+    }
+  };
+
+  template <class F, class... Args>
+  requires std::is_constructible_v<std::decay_t<F>, F>
+           and std::is_move_constructible_v<std::decay_t<F>>
+           and (std::is_constructible_v<std::decay_t<Args>, Args> and ...)
+           and (std::is_move_constructible_v<std::decay_t<Args>> and ...)
+  constexpr bind_back_t<std::decay_t<F>, std::index_sequence_for<Args...>,
+                        std::decay_t<Args>...>
+  bind_back(F&& f, Args&&... args) {
+    return {std::forward<F>(f), {std::forward<Args>(args)...}};
+  }
+
+  // 遅延パイプライン: o | mtransform(f) | mand_then(g) | ...
+  // 各段は値 v と後続の処理 k を受け取る関数 (継続渡し) で、パイプライン全体は
+  // コンパイル時に 1 つの関数に合成される。評価時に有効性を検査するのは
+  // 元の optional と各 and_then の結果だけであり、中間の optional は生成しない
+  // (値は参照のまま後続の段へ渡され、最後に 1 度だけ optional に格納される)
+
+  // v に f を適用して k へ渡す。検査は不要
+  struct __transform_step {
+    template <class T, class K, class F>
+    constexpr decltype(auto) operator()(T&& v, K&& k, F&& f) const {
+      return std::invoke(std::forward<K>(k),
+                         std::invoke(std::forward<F>(f), std::forward<T>(v)));
+    }
+  };
+
+  // v に f を適用し、結果が有効値を持つ場合に限りその値を k へ渡す
+  struct __and_then_step {
+    template <class T, class K, class F>
+    constexpr auto operator()(T&& v, K&& k, F&& f) const {
+      auto&& r = std::invoke(std::forward<F>(f), std::forward<T>(v));
+      using R = std::invoke_result_t<K&&, decltype(*std::move(r))>;
+      if (r)
+        return std::invoke(std::forward<K>(k), *std::move(r));
+      else
+        return R(std::nullopt);
+    }
+  };
+
+  /// パイプラインの 1 段。Fn は (v, k) を受け取る
+  template <class Fn>
+  struct __stage {
+    Fn fn;
+  };
+
+  template <class F>
+  constexpr auto mtransform(F&& f) {
+    return __stage{bind_back(__transform_step{}, std::forward<F>(f))};
+  }
+
+  template <class F>
+  constexpr auto mand_then(F&& f) {
+    return __stage{bind_back(__and_then_step{}, std::forward<F>(f))};
+  }
+
+  // I 番目以降の段を v に適用する。後続の段は継続として渡す
+  template <std::size_t I, class Fns, class V>
+  constexpr auto __run_stages(Fns& fns, V&& v) {
+    if constexpr (I == std::tuple_size_v<Fns>)
+      return optional<std::remove_cvref_t<V>>(std::forward<V>(v));
+    else
+      return std::get<I>(fns)(std::forward<V>(v), [&fns](auto&& w) {
+        return __run_stages<I + 1>(fns, std::forward<decltype(w)>(w));
+      });
+  }
+
+  /// 元の optional と段の列を保持し、eval() または optional への変換で評価する
+  /// Src は元の optional が左辺値であれば参照、右辺値であれば値
+  template <class Src, class... Fns>
+  struct __lazy_optional {
+    Src src;
+    std::tuple<Fns...> fns;
+
+    using result_type = decltype(__run_stages<0>(
+      std::declval<std::tuple<Fns...>&>(),
+      *std::forward<Src>(std::declval<Src&>())));
+
+    constexpr result_type eval() && {
+      if (src)
+        return __run_stages<0>(fns, *std::forward<Src>(src));
+      else
+        return std::nullopt;
+    }
+
+    constexpr operator result_type() && { return std::move(*this).eval(); }
+  };
+
+  template <class O, class Fn>
+  requires __is_optional_v<std::remove_cvref_t<O>>
+  constexpr auto operator|(O&& o, __stage<Fn> s) {
+    using Src = std::conditional_t<std::is_lvalue_reference_v<O>, O,
+                                   std::remove_cvref_t<O>>;
+    return __lazy_optional<Src, Fn>{std::forward<O>(o), {std::move(s.fn)}};
+  }
+
+  template <class Src, class... Fns, class Fn>
+  constexpr auto operator|(__lazy_optional<Src, Fns...>&& l, __stage<Fn> s) {
+    return __lazy_optional<Src, Fns..., Fn>{
+      std::forward<Src>(l.src),
+      std::tuple_cat(std::move(l.fns), std::tuple<Fn>(std::move(s.fn)))};
+  }
 } // namespace ns
 
+enum class user_id : std::uint32_t {};
+template <>
+struct ns::niche_traits<user_id>
+  : ns::sentinel_niche<user_id, user_id{~std::uint32_t{0}}> {};
+
+enum class math_error : std::uint8_t { negative, overflow };
+
+// コピーとムーブの回数を数える
+struct counted {
+  int value;
+  static inline int copies = 0, moves = 0;
+  constexpr counted(int v) : value(v) {}
+  counted(const counted& other) : value(other.value) { ++copies; }
+  counted(counted&& other) noexcept : value(other.value) { ++moves; }
+};
+
 #define FWD(x) static_cast<decltype(x)&&>(x)
 
 int main() {
@@ -105,4 +471,133 @@ int main() {
     assert(o1.or_else(twelve) == ns::optional(42));
     assert(o2.or_else(twelve) == ns::optional(12));
   }
+  {
+    // 無効値を持つ型は有効性のフラグを持たない
+    static_assert(sizeof(ns::optional<double>) == sizeof(double));
+    static_assert(sizeof(ns::optional<float>) == sizeof(float));
+    static_assert(sizeof(ns::optional<int*>) == sizeof(int*));
+    static_assert(sizeof(ns::optional<user_id>) == sizeof(user_id));
+    static_assert(sizeof(ns::optional<int>) > sizeof(int));
+    static_assert(std::is_trivially_copyable_v<ns::optional<double>>);
+
+    constexpr ns::optional<double> d1(2.0), d2;
+    static_assert(d1.transform([](double x) { return x * 3; })
+                  == ns::optional(6.0));
+    static_assert(d2.transform([](double x) { return x * 3; })
+                  == std::nullopt);
+    static_assert(d2 < d1 and d1 <=> d1 == 0);
+    // 無効値と同じ表現の NaN は有効な NaN として格納される
+    const auto nan = ns::niche_traits<double>::invalid();
+    ns::optional<double> d3(nan);
+    assert(d3.has_value() and std::isnan(*d3));
+    assert((ns::optional(std::nan("")) <=> d1)
+           == std::partial_ordering::unordered);
+
+    int x = 42;
+    ns::optional<int*> p1(&x), p2, p3(nullptr);
+    auto deref = [](int* p) -> ns::optional<int> {
+      if (p)
+        return *p;
+      else
+        return std::nullopt;
+    };
+    assert(p1.and_then(deref) == ns::optional(42));
+    assert(p2.and_then(deref) == std::nullopt);
+    assert(p3.has_value() and p3.and_then(deref) == std::nullopt);
+    assert(p2.or_else([&] { return ns::optional(&x); }) == p1);
+
+    constexpr ns::optional<user_id> u1(user_id{7}), u2;
+    static_assert(u1.value() == user_id{7} and not u2);
+    static_assert(u2.value_or(user_id{0}) == user_id{0});
+    static_assert(u2 < u1);
+  }
+  {
+    using result = ns::expected<int, math_error>;
+    static_assert(std::is_trivially_copy_constructible_v<result>
+                  and std::is_trivially_destructible_v<result>
+                  and sizeof(result) == 2 * sizeof(int));
+    result e1(42), e2(std::unexpected(math_error::negative));
+    auto add_one = [](auto&& x) { return FWD(x) + 1; };
+    assert(e1.transform(add_one) == 43);
+    assert(e2.transform(add_one).error() == math_error::negative);
+
+    auto sqrt = [](int x) -> result {
+      if (x < 0)
+        return std::unexpected(math_error::negative);
+      else
+        return static_cast<int>(std::sqrt(x));
+    };
+    assert(e1.and_then(sqrt) == 6);
+    assert(result(-1).and_then(sqrt).error() == math_error::negative);
+    assert(e2.and_then(sqrt).error() == math_error::negative);
+
+    auto recover = [](math_error e) -> result {
+      if (e == math_error::negative)
+        return 0;
+      else
+        return std::unexpected(e);
+    };
+    assert(e1.or_else(recover) == 42);
+    assert(e2.or_else(recover) == 0);
+
+    auto describe = [](math_error e) {
+      return e == math_error::negative ? "negative" : "overflow";
+    };
+    assert(e1.transform_error(describe) == 42);
+    assert(e2.transform_error(describe).error() == std::string("negative"));
+  }
+  {
+    constexpr auto twice = [](int x) { return x * 2; };
+    constexpr auto half_if_even = [](int x) -> ns::optional<int> {
+      if (x % 2 == 0)
+        return x / 2;
+      else
+        return std::nullopt;
+    };
+    ns::optional<int> o1(4), o2;
+    ns::optional<int> r1 =
+      o1 | ns::mtransform(twice) | ns::mand_then(half_if_even);
+    assert(r1 and *r1 == 4);
+    assert((o2 | ns::mtransform(twice)).eval() == std::nullopt);
+    assert((ns::optional(3) | ns::mand_then(half_if_even)
+            | ns::mtransform(twice))
+             .eval()
+           == std::nullopt);
+    static_assert(*(ns::optional(6) | ns::mand_then(half_if_even)
+                    | ns::mtransform(twice))
+                     .eval()
+                  == 6);
+    for (int i = -4; i <= 4; ++i) {
+      ns::optional o(i);
+      assert((o | ns::mand_then(half_if_even) | ns::mtransform(twice)
+              | ns::mand_then(half_if_even))
+               .eval()
+             == o.and_then(half_if_even)
+                  .transform(twice)
+                  .and_then(half_if_even));
+    }
+
+    // 中間の optional を生成しないため、値のムーブは少なくて済む
+    auto inc = [](const counted& c) { return counted(c.value + 1); };
+    auto dbl = [](counted&& c) {
+      c.value *= 2;
+      return std::move(c);
+    };
+    auto positive = [](counted&& c) -> ns::optional<counted> {
+      if (c.value > 0)
+        return std::move(c);
+      else
+        return std::nullopt;
+    };
+    ns::optional<counted> o3(counted(1));
+    counted::copies = counted::moves = 0;
+    auto eager = o3.transform(inc).transform(dbl).and_then(positive);
+    const int eager_moves = counted::moves;
+    counted::moves = 0;
+    ns::optional<counted> lazy = o3 | ns::mtransform(inc)
+                                 | ns::mtransform(dbl)
+                                 | ns::mand_then(positive);
+    assert(eager->value == 4 and lazy->value == 4);
+    assert(counted::copies == 0 and counted::moves < eager_moves);
+  }
 }
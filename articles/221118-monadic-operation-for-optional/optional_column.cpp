@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// for main
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace ns {
+  template <class T>
+  concept __column_element =
+    std::is_trivially_copyable_v<T> and std::default_initializable<T>;
+
+  template <__column_element T>
+  struct optional_column;
+
+  template <class T>
+  inline constexpr bool __is_std_optional_v = false;
+  template <class T>
+  inline constexpr bool __is_std_optional_v<std::optional<T>> = true;
+
+  /// null を含みうる値の列
+  /// 値は密な配列に、有効性は 1 bit/要素 のビットマップ (Arrow 形式: LSB から順)
+  /// に格納する。無効な要素の値は常に T{} であり、ビットマップの末尾の余りは 0
+  ///
+  /// transform/and_then は無効な要素に対しても関数を呼び出し、その結果を捨てる
+  /// (分岐をなくしてベクトル化するため)。したがって関数は T{} を含む任意の値に
+  /// 対して未定義動作を起こしてはならず、副作用を持つべきではない
+  ///
+  /// 右辺値に対する transform/and_then/or_else は、要素型が変わらなければ自身を上書きして返す。
+  /// c.transform(f).and_then(g).or_else(h) では列の確保は 1 段目の 1 度だけになる
+  template <__column_element T>
+  struct optional_column {
+    using value_type = std::optional<T>;
+
+  private:
+    template <__column_element U>
+    friend struct optional_column;
+
+    static constexpr std::size_t word_bits = 64;
+
+    std::vector<T> values_;
+    std::vector<std::uint64_t> validity_;
+
+    static constexpr std::size_t __words(std::size_t n) noexcept {
+      return (n + word_bits - 1) / word_bits;
+    }
+
+    // validity_ の b 番目のワードが受け持つ要素の範囲
+    constexpr std::pair<std::size_t, std::size_t>
+    __block(std::size_t b) const noexcept {
+      const std::size_t first = b * word_bits;
+      return {first, std::min(first + word_bits, size())};
+    }
+
+    // ワード w の各 bit を 0 または 1 のバイトに展開する
+    static constexpr void __unpack(std::uint64_t w,
+                                   std::uint8_t (&m)[word_bits]) noexcept {
+      for (std::size_t j = 0; j < word_bits; ++j)
+        m[j] = static_cast<std::uint8_t>((w >> j) & 1);
+    }
+    // 0 または 1 のバイトの列を 1 ワードに詰める
+    // 8 バイトを 1 つの整数として読み、各バイトの bit 0 を乗算で最上位バイトに集める
+    static constexpr std::uint64_t
+    __pack(const std::uint8_t (&m)[word_bits]) noexcept {
+      std::uint64_t w = 0;
+      for (std::size_t k = 0; k < word_bits / 8; ++k) {
+        std::uint64_t x = 0;
+        for (std::size_t i = 0; i < 8; ++i)
+          x |= std::uint64_t{m[8 * k + i]} << (8 * i);
+        w |= (x * 0x0102040810204080) >> 56 << (8 * k);
+      }
+      return w;
+    }
+
+    // ワードごとに block(in, out, n, w) を呼び、その戻り値を out の有効性とする
+    // block は in[0, word_bits) を読み、先頭 n 個の値を out に書く。
+    // 要素数を定数とすることで、-O2 (GCC の very-cheap コストモデル) でもベクトル化される。
+    // 末尾の余りは T{} で埋めた一時領域で処理する。out は *this であってもよい
+    template <class U, class Block>
+    constexpr void __for_each_block(optional_column<U>& out, Block block) const {
+      const std::size_t full = size() / word_bits;
+      for (std::size_t b = 0; b < full; ++b)
+        out.validity_[b] = block(values_.data() + b * word_bits,
+                                 out.values_.data() + b * word_bits, word_bits,
+                                 validity_[b]);
+      if (const std::size_t rest = size() - full * word_bits; rest != 0) {
+        T tail[word_bits]{};
+        std::copy_n(values_.data() + full * word_bits, rest, tail);
+        out.validity_[full] = block(tail, out.values_.data() + full * word_bits,
+                                    rest, validity_[full]);
+      }
+    }
+
+    template <class F, class U>
+    constexpr void __transform_into(F& f, optional_column<U>& out) const {
+      __for_each_block(out, [&f](const T* in, U* o, std::size_t n,
+                                 std::uint64_t w) {
+        std::uint8_t ok[word_bits];
+        U vals[word_bits];
+        __unpack(w, ok);
+        for (std::size_t j = 0; j < word_bits; ++j) {
+          const U r = std::invoke(f, in[j]);
+          vals[j] = ok[j] ? r : U{};
+        }
+        // 一時領域を経由するため、in と o が同じ位置を指してもよい
+        std::copy_n(vals, n, o);
+        return w;
+      });
+    }
+
+    template <class F, class U>
+    constexpr void __and_then_into(F& f, optional_column<U>& out) const {
+      __for_each_block(out, [&f](const T* in, U* o, std::size_t n,
+                                 std::uint64_t w) {
+        std::uint8_t ok[word_bits];
+        U vals[word_bits];
+        __unpack(w, ok);
+        for (std::size_t j = 0; j < word_bits; ++j) {
+          // f の結果を直ちに値と 0/1 に分解し、以降を分岐のない選択にする
+          U v{};
+          std::uint8_t h = 0;
+          if (auto r = std::invoke(f, in[j])) {
+            v = *r;
+            h = 1;
+          }
+          h &= ok[j];
+          vals[j] = h ? v : U{};
+          ok[j] = h;
+        }
+        std::copy_n(vals, n, o);
+        return __pack(ok);
+      });
+    }
+
+  public:
+    constexpr optional_column() = default;
+    /// すべて null の列
+    constexpr explicit optional_column(std::size_t n)
+      : values_(n), validity_(__words(n)) {}
+    template <std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>,
+                                 std::optional<T>>
+    constexpr explicit optional_column(R&& r) {
+      if constexpr (std::ranges::sized_range<R>) {
+        values_.reserve(std::ranges::size(r));
+        validity_.reserve(__words(std::ranges::size(r)));
+      }
+      for (auto&& x : r)
+        push_back(std::forward<decltype(x)>(x));
+    }
+
+    constexpr std::size_t size() const noexcept { return values_.size(); }
+    constexpr bool empty() const noexcept { return values_.empty(); }
+    constexpr std::span<const T> values() const noexcept { return values_; }
+    constexpr std::span<const std::uint64_t> validity() const noexcept {
+      return validity_;
+    }
+
+    constexpr bool is_valid(std::size_t i) const noexcept {
+      return (validity_[i / word_bits] >> (i % word_bits)) & 1;
+    }
+    constexpr std::optional<T> operator[](std::size_t i) const noexcept {
+      if (is_valid(i))
+        return values_[i];
+      else
+        return std::nullopt;
+    }
+    constexpr std::size_t null_count() const noexcept {
+      std::size_t n = 0;
+      for (std::uint64_t w : validity_)
+        n += static_cast<std::size_t>(std::popcount(w));
+      return size() - n;
+    }
+
+    constexpr void push_back(const std::optional<T>& x) {
+      const std::size_t i = size();
+      if (i % word_bits == 0)
+        validity_.push_back(0);
+      values_.push_back(x.value_or(T{}));
+      validity_.back() |= std::uint64_t{x.has_value()} << (i % word_bits);
+    }
+
+    /// 有効な要素に f を適用する。有効性はそのまま引き継ぐ
+    template <class F>
+    requires std::invocable<F&, const T&>
+    constexpr auto transform(F f) const&
+      -> optional_column<
+        std::remove_cvref_t<std::invoke_result_t<F&, const T&>>> {
+      using U = std::remove_cvref_t<std::invoke_result_t<F&, const T&>>;
+      optional_column<U> out;
+      out.values_.resize(size());
+      out.validity_.resize(validity_.size());
+      __transform_into(f, out);
+      return out;
+    }
+    /// 結果の要素型が T であれば、値を上書きして自身を返す
+    /// (段を連ねても列は 1 度しか確保されない)
+    template <class F>
+    requires std::invocable<F&, const T&>
+    constexpr auto transform(F f) &&
+      -> optional_column<
+        std::remove_cvref_t<std::invoke_result_t<F&, const T&>>> {
+      using U = std::remove_cvref_t<std::invoke_result_t<F&, const T&>>;
+      if constexpr (std::same_as<U, T>) {
+        __transform_into(f, *this);
+        return std::move(*this);
+      } else {
+        return std::as_const(*this).transform(std::move(f));
+      }
+    }
+
+    /// 有効な要素に std::optional を返す f を適用する
+    /// 結果の有効性は、元の有効性と f の結果の有効性のビットごとの論理積
+    template <class F>
+    requires std::invocable<F&, const T&>
+             and __is_std_optional_v<
+               std::remove_cvref_t<std::invoke_result_t<F&, const T&>>>
+    constexpr auto and_then(F f) const&
+      -> optional_column<typename std::remove_cvref_t<
+        std::invoke_result_t<F&, const T&>>::value_type> {
+      using U = typename std::remove_cvref_t<
+        std::invoke_result_t<F&, const T&>>::value_type;
+      optional_column<U> out;
+      out.values_.resize(size());
+      out.validity_.resize(validity_.size());
+      __and_then_into(f, out);
+      return out;
+    }
+    /// 結果の要素型が T であれば、値と有効性を上書きして自身を返す
+    template <class F>
+    requires std::invocable<F&, const T&>
+             and __is_std_optional_v<
+               std::remove_cvref_t<std::invoke_result_t<F&, const T&>>>
+    constexpr auto and_then(F f) &&
+      -> optional_column<typename std::remove_cvref_t<
+        std::invoke_result_t<F&, const T&>>::value_type> {
+      using U = typename std::remove_cvref_t<
+        std::invoke_result_t<F&, const T&>>::value_type;
+      if constexpr (std::same_as<U, T>) {
+        __and_then_into(f, *this);
+        return std::move(*this);
+      } else {
+        return std::as_const(*this).and_then(std::move(f));
+      }
+    }
+
+    /// null の要素を other の対応する要素で置き換える
+    /// 結果の有効性は両者の有効性のビットごとの論理和
+    constexpr optional_column or_else(const optional_column& other) const& {
+      return optional_column(*this).or_else(other);
+    }
+    constexpr optional_column or_else(const optional_column& other) && {
+      assert(other.size() == size());
+      for (std::size_t b = 0; b < validity_.size(); ++b) {
+        const auto [first, last] = __block(b);
+        std::uint8_t ok[word_bits];
+        T vals[word_bits];
+        __unpack(validity_[b], ok);
+        // 満たされたワードでは要素数を定数にする (__for_each_block を参照)
+        auto merge = [&](std::size_t n) {
+          for (std::size_t j = 0; j < n; ++j) {
+            const T x = values_[first + j], y = other.values_[first + j];
+            vals[j] = ok[j] ? x : y;
+          }
+        };
+        if (last - first == word_bits)
+          merge(word_bits);
+        else
+          merge(last - first);
+        std::copy_n(vals, last - first, values_.data() + first);
+        validity_[b] |= other.validity_[b];
+      }
+      return std::move(*this);
+    }
+
+    /// null の要素を f() の結果で置き換える。f は高々 1 度だけ呼ばれる
+    template <class F>
+    requires std::invocable<F&>
+             and std::same_as<std::remove_cvref_t<std::invoke_result_t<F&>>,
+                              std::optional<T>>
+    constexpr optional_column or_else(F f) const& {
+      return optional_column(*this).or_else(std::move(f));
+    }
+    template <class F>
+    requires std::invocable<F&>
+             and std::same_as<std::remove_cvref_t<std::invoke_result_t<F&>>,
+                              std::optional<T>>
+    constexpr optional_column or_else(F f) && {
+      if (null_count() == 0)
+        return std::move(*this);
+      const std::optional<T> fill = std::invoke(f);
+      if (not fill)
+        return std::move(*this);
+      const T x = *fill;
+      __for_each_block(*this, [x](const T* in, T* o, std::size_t n,
+                                  std::uint64_t w) {
+        std::uint8_t ok[word_bits];
+        T vals[word_bits];
+        __unpack(w, ok);
+        for (std::size_t j = 0; j < word_bits; ++j) {
+          const T v = in[j];
+          vals[j] = ok[j] ? v : x;
+        }
+        std::copy_n(vals, n, o);
+        // 末尾の余りの bit は立てない
+        return n == word_bits ? ~std::uint64_t{0} : (std::uint64_t{1} << n) - 1;
+      });
+      return std::move(*this);
+    }
+
+    friend constexpr bool operator==(const optional_column&,
+                                     const optional_column&) = default;
+  };
+
+  template <std::ranges::input_range R>
+  optional_column(R&&) -> optional_column<typename std::remove_cvref_t<
+    std::ranges::range_reference_t<R>>::value_type>;
+} // namespace ns
+
+// 計測に用いる関数
+// main に展開されると、GCC は main を 1 度しか実行されない関数とみなして最適化を抑えるため、
+// 関数ポインタを介して呼び出す
+using elements = std::vector<std::optional<std::int32_t>>;
+using column = ns::optional_column<std::int32_t>;
+
+constexpr auto triple = [](std::int32_t x) { return x * 3; };
+constexpr auto half_if_even = [](std::int32_t x) -> std::optional<std::int32_t> {
+  if (x % 2 == 0)
+    return x / 2;
+  else
+    return std::nullopt;
+};
+constexpr auto seven = [] { return std::optional(7); };
+
+constexpr auto transform_op = [](const auto& x) { return x.transform(triple); };
+constexpr auto and_then_op = [](const auto& x) { return x.and_then(half_if_even); };
+constexpr auto or_else_op = [](const auto& x) { return x.or_else(seven); };
+// 列の場合、2 段目以降は右辺値に対して呼ばれ、1 段目の結果を上書きする
+constexpr auto pipeline_op = [](const auto& x) {
+  return x.transform(triple).and_then(half_if_even).or_else(seven);
+};
+
+// 1 要素ずつ: std::optional の配列に書き出す
+template <auto Op>
+elements per_element(const elements& xs) {
+  elements ys(xs.size());
+  for (std::size_t i = 0; i < xs.size(); ++i)
+    ys[i] = Op(xs[i]);
+  return ys;
+}
+
+// 列ごと
+template <auto Op>
+column columnar(const column& c) {
+  return Op(c);
+}
+
+int main() {
+  // 1 要素ずつ std::optional で計算した結果と比較する
+  std::mt19937 gen(42);
+  std::bernoulli_distribution has_value(0.9);
+  std::uniform_int_distribution<std::int32_t> value(-1000, 1000);
+  for (std::size_t n : {0, 1, 63, 64, 65, 200}) {
+    std::vector<std::optional<std::int32_t>> xs(n), ys(n);
+    for (auto& x : xs)
+      x = has_value(gen) ? std::optional(value(gen)) : std::nullopt;
+    for (auto& y : ys)
+      y = has_value(gen) ? std::optional(value(gen)) : std::nullopt;
+    const column cx(xs), cy(ys);
+    assert(cx.size() == n);
+    const auto t = cx.transform(triple);
+    const auto a = cx.and_then(half_if_even);
+    const auto o = cx.or_else(cy);
+    const auto f = cx.or_else(seven);
+    const auto g = cx.or_else([] { return std::optional<std::int32_t>(); });
+    // 右辺値に対する段は自身を上書きする
+    const auto p = column(cx).transform(triple).and_then(half_if_even).or_else(cy);
+    for (std::size_t i = 0; i < n; ++i) {
+      assert(cx[i] == xs[i]);
+      assert(t[i] == xs[i].transform(triple));
+      assert(a[i] == xs[i].and_then(half_if_even));
+      assert(o[i] == xs[i].or_else([&] { return ys[i]; }));
+      assert(f[i] == xs[i].or_else(seven));
+      assert(g[i] == xs[i]);
+      assert(p[i] == xs[i].transform(triple).and_then(half_if_even).or_else([&] {
+        return ys[i];
+      }));
+      // 無効な要素の値は T{}
+      assert(t[i] or t.values()[i] == 0);
+      assert(a[i] or a.values()[i] == 0);
+    }
+    assert(f.null_count() == 0);
+  }
+
+  // 計測: 1 要素ずつ適用する場合と列ごとに適用する場合
+  constexpr std::size_t n = 10'000'000;
+  std::vector<std::optional<std::int32_t>> xs(n);
+  for (auto& x : xs)
+    x = has_value(gen) ? std::optional(value(gen)) : std::nullopt;
+  const column cx(xs);
+  using clock = std::chrono::steady_clock;
+  auto ms = [](auto t0) {
+    return std::chrono::duration<double, std::milli>(clock::now() - t0)
+      .count();
+  };
+
+  // 5 回計測して最小値をとる
+  auto best_of = [&](auto f) {
+    double best = 1e300;
+    for (int rep = 0; rep < 5; ++rep) {
+      const auto t0 = clock::now();
+      f();
+      best = std::min(best, ms(t0));
+    }
+    return best;
+  };
+
+  using elements_fn = elements (*)(const elements&);
+  using column_fn = column (*)(const column&);
+  auto bench = [&](const char* name, elements_fn elem, column_fn col) {
+    elements ys;
+    column cy;
+    const double te = best_of([&] { ys = elem(xs); });
+    const double tc = best_of([&] { cy = col(cx); });
+    for (std::size_t i = 0; i < n; ++i)
+      assert(cy[i] == ys[i]);
+    std::cout << name << "\tper element: " << te << " ms\tcolumn: " << tc
+              << " ms\n";
+  };
+  bench("transform", per_element<transform_op>, columnar<transform_op>);
+  bench("and_then", per_element<and_then_op>, columnar<and_then_op>);
+  bench("or_else", per_element<or_else_op>, columnar<or_else_op>);
+  bench("pipeline", per_element<pipeline_op>, columnar<pipeline_op>);
+}
@@ -0,0 +1,193 @@
+#include <cassert>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <vector>
+// for main
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+using namespace std; // 見やすさのため
+
+template <integral Int>
+constexpr auto parse(string_view sv) -> optional<Int> {
+  Int n{};
+  auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+  if (ec == errc{} and ptr == sv.data() + sv.size())
+    return n;
+  else
+    return nullopt;
+}
+
+// 従来の実装: 呼び出しごとに vector を確保する
+constexpr auto parse_expr(string_view sv) {
+  const auto toks = sv | views::split(' ') | ranges::to<vector>();
+  return parse<int32_t>(string_view(toks[0])) //
+    .and_then([&](int32_t n) {
+      return parse<int32_t>(string_view(toks[2]))
+        .and_then([&](int32_t m) -> optional<int32_t> {
+          switch (toks[1][0]) {
+          case '+':
+            return n + m;
+          case '-':
+            return n - m;
+          case '*':
+            return n * m;
+          case '/':
+            return n / m;
+          default:
+            return nullopt;
+          }
+        });
+    });
+}
+
+// sv の先頭から ' ' までを切り出し、sv をその次の位置まで進める
+constexpr auto next_token(string_view& sv) -> string_view {
+  const auto pos = sv.find(' ');
+  const auto tok = sv.substr(0, pos);
+  sv.remove_prefix(pos == string_view::npos ? sv.size() : pos + 1);
+  return tok;
+}
+
+// メモリ確保を行わない実装
+// トークンが足りない場合、オーバーフローする場合と 0 除算 (および INT32_MIN / -1) は nullopt を返す
+constexpr auto parse_expr_view(string_view sv) -> optional<int32_t> {
+  const auto lhs = next_token(sv);
+  const auto op = next_token(sv);
+  const auto rhs = next_token(sv);
+  if (op.empty())
+    return nullopt;
+  return parse<int32_t>(lhs) //
+    .and_then([&](int32_t n) {
+      return parse<int32_t>(rhs) //
+        .and_then([&](int32_t m) -> optional<int32_t> {
+          int32_t r{};
+          switch (op[0]) {
+          case '+':
+            return __builtin_add_overflow(n, m, &r) ? nullopt : optional(r);
+          case '-':
+            return __builtin_sub_overflow(n, m, &r) ? nullopt : optional(r);
+          case '*':
+            return __builtin_mul_overflow(n, m, &r) ? nullopt : optional(r);
+          case '/':
+            if (m == 0 or (n == numeric_limits<int32_t>::min() and m == -1))
+              return nullopt;
+            return n / m;
+          default:
+            return nullopt;
+          }
+        });
+    });
+}
+
+// 各行を評価し、結果を values に、成否を ok に書き込む
+// values と ok は lines.size() 以上の長さを持たなければならない
+constexpr void parse_expr_batch(span<const string_view> lines,
+                                span<int32_t> values, span<bool> ok) {
+  assert(values.size() >= lines.size() and ok.size() >= lines.size());
+  for (size_t i = 0; i < lines.size(); ++i) {
+    const auto r = parse_expr_view(lines[i]);
+    values[i] = r.value_or(0);
+    ok[i] = r.has_value();
+  }
+}
+
+// 改行区切りのバッファを先頭から評価し、評価した行数を返す
+// 出力先が埋まった場合はそこで打ち切る。末尾の改行は省略してもよい
+constexpr size_t parse_expr_batch(string_view buf, span<int32_t> values,
+                                  span<bool> ok) {
+  const size_t capacity = min(values.size(), ok.size());
+  size_t i = 0;
+  for (; i < capacity and not buf.empty(); ++i) {
+    const auto pos = buf.find('\n');
+    const auto r = parse_expr_view(buf.substr(0, pos));
+    values[i] = r.value_or(0);
+    ok[i] = r.has_value();
+    buf.remove_prefix(pos == string_view::npos ? buf.size() : pos + 1);
+  }
+  return i;
+}
+
+int main() {
+  assert(parse_expr_view("1 + 2"sv) == optional(1 + 2));
+  assert(parse_expr_view("478 - 234"sv) == optional(478 - 234));
+  assert(parse_expr_view("15 * 56"sv) == optional(15 * 56));
+  assert(parse_expr_view("98 / 12"sv) == optional(98 / 12));
+  assert(parse_expr_view("98 / 0"sv) == nullopt);
+  // オーバーフローも 0 除算と同じく nullopt
+  assert(parse_expr_view("2147483647 + 1"sv) == nullopt);
+  assert(parse_expr_view("-2147483648 - 1"sv) == nullopt);
+  assert(parse_expr_view("65536 * 32768"sv) == nullopt);
+  assert(parse_expr_view("-2147483648 / -1"sv) == nullopt);
+  assert(parse_expr_view("2147483646 + 1"sv) == optional(2147483647));
+  assert(parse_expr_view("-65536 * 32768"sv) == optional(-2147483647 - 1));
+  assert(parse_expr_view("1 +"sv) == nullopt);
+  assert(parse_expr_view("1 % 2"sv) == nullopt);
+  assert(parse_expr_view(""sv) == nullopt);
+
+  {
+    const string_view lines[]{"1 + 2", "x + 2", "7 * 6"};
+    int32_t values[3];
+    bool ok[3];
+    parse_expr_batch(lines, values, ok);
+    assert(values[0] == 3 and ok[0]);
+    assert(not ok[1]);
+    assert(values[2] == 42 and ok[2]);
+  }
+  {
+    int32_t values[4];
+    bool ok[4];
+    assert(parse_expr_batch("1 + 2\n3 - 4\n5 / 0"sv, values, ok) == 3);
+    assert(values[0] == 3 and ok[0]);
+    assert(values[1] == -1 and ok[1]);
+    assert(not ok[2]);
+  }
+
+  // スループットの計測
+  constexpr size_t n = 1'000'000;
+  string buf;
+  vector<string_view> lines;
+  {
+    const char* ops = "+-*/";
+    for (size_t i = 0; i < n; ++i)
+      buf += to_string(i % 10007) + ' ' + ops[i % 4] + ' '
+             + to_string(i % 97 + 1) + '\n';
+    string_view rest = buf;
+    while (not rest.empty()) {
+      const auto pos = rest.find('\n');
+      lines.push_back(rest.substr(0, pos));
+      rest.remove_prefix(pos + 1);
+    }
+  }
+  vector<int32_t> values(n);
+  // vector<bool> は span<bool> に変換できないため配列で確保する
+  auto ok = make_unique<bool[]>(n);
+
+  using clock = chrono::steady_clock;
+  auto lines_per_sec = [&](auto f) {
+    const auto t0 = clock::now();
+    f();
+    return n / chrono::duration<double>(clock::now() - t0).count();
+  };
+  int64_t checksum = 0;
+  const double old_rate = lines_per_sec([&] {
+    for (auto line : lines)
+      checksum += parse_expr(line).value_or(0);
+  });
+  const double span_rate = lines_per_sec(
+    [&] { parse_expr_batch(lines, values, span(ok.get(), n)); });
+  const double buf_rate = lines_per_sec(
+    [&] { parse_expr_batch(string_view(buf), values, span(ok.get(), n)); });
+  cout << "parse_expr:                " << old_rate << " lines/s\n"
+       << "parse_expr_batch (span):   " << span_rate << " lines/s\n"
+       << "parse_expr_batch (buffer): " << buf_rate << " lines/s\n"
+       << "(checksum " << checksum << ")" << endl;
+}
@@ -0,0 +1,228 @@
+#include <cassert>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+// for main
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std; // 見やすさのため
+
+// monadic_op.cpp より
+namespace ns {
+  template <class T, class U>
+  using __forward_like_t = decltype(std::forward_like<T>(std::declval<U>()));
+
+  template <class T, class E>
+  struct expected;
+
+  template <class T>
+  inline constexpr bool __is_expected_v = false;
+  template <class T, class E>
+  inline constexpr bool __is_expected_v<expected<T, E>> = true;
+
+  template <class T, class E>
+  struct expected : std::expected<T, E> {
+    using std::expected<T, E>::expected;
+
+    template <class Self, std::invocable<__forward_like_t<Self, T>> F>
+    constexpr auto transform(this Self&& self, F&& f)
+      -> expected<std::remove_cvref_t<
+                    std::invoke_result_t<F&&, __forward_like_t<Self, T>>>,
+                  E> {
+      if (self)
+        return std::invoke(std::forward<F>(f), std::forward_like<Self>(*self));
+      else
+        return std::unexpected(std::forward_like<Self>(self.error()));
+    }
+
+    template <class Self, std::invocable<__forward_like_t<Self, T>> F>
+    requires __is_expected_v<
+      std::remove_cvref_t<std::invoke_result_t<F&&, __forward_like_t<Self, T>>>>
+    constexpr auto and_then(this Self&& self, F&& f) -> std::remove_cvref_t<
+      std::invoke_result_t<F&&, __forward_like_t<Self, T>>> {
+      if (self)
+        return std::invoke(std::forward<F>(f), std::forward_like<Self>(*self));
+      else
+        return std::unexpected(std::forward_like<Self>(self.error()));
+    }
+  };
+} // namespace ns
+
+// 失敗の理由。1 バイトに収まるため、expected<int32_t, parse_error> は
+// 8 バイトとなりレジスタで返される
+enum class parse_error : uint8_t {
+  invalid_number,
+  out_of_range,
+  missing_token,
+  unknown_operator,
+  division_by_zero,
+};
+
+constexpr auto to_string(parse_error e) -> string_view {
+  switch (e) {
+  case parse_error::invalid_number:
+    return "invalid number";
+  case parse_error::out_of_range:
+    return "out of range";
+  case parse_error::missing_token:
+    return "missing token";
+  case parse_error::unknown_operator:
+    return "unknown operator";
+  case parse_error::division_by_zero:
+    return "division by zero";
+  }
+  return "unknown";
+}
+
+template <class T>
+using result = ns::expected<T, parse_error>;
+
+static_assert(sizeof(result<int32_t>) == 8);
+static_assert(is_trivially_copy_constructible_v<result<int32_t>>
+              and is_trivially_destructible_v<result<int32_t>>);
+
+template <integral Int>
+constexpr auto parse(string_view sv) -> result<Int> {
+  Int n{};
+  auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+  if (ec == errc{} and ptr == sv.data() + sv.size())
+    return n;
+  else if (ec == errc::result_out_of_range)
+    return unexpected(parse_error::out_of_range);
+  else
+    return unexpected(parse_error::invalid_number);
+}
+
+// parse_expr_batch.cpp より
+constexpr auto next_token(string_view& sv) -> string_view {
+  const auto pos = sv.find(' ');
+  const auto tok = sv.substr(0, pos);
+  sv.remove_prefix(pos == string_view::npos ? sv.size() : pos + 1);
+  return tok;
+}
+
+constexpr auto parse_expr(string_view sv) -> result<int32_t> {
+  const auto lhs = next_token(sv);
+  const auto op = next_token(sv);
+  const auto rhs = next_token(sv);
+  if (op.empty() or rhs.empty())
+    return unexpected(parse_error::missing_token);
+  return parse<int32_t>(lhs) //
+    .and_then([&](int32_t n) {
+      return parse<int32_t>(rhs) //
+        .and_then([&](int32_t m) -> result<int32_t> {
+          switch (op[0]) {
+          case '+':
+            return n + m;
+          case '-':
+            return n - m;
+          case '*':
+            return n * m;
+          case '/':
+            if (m == 0)
+              return unexpected(parse_error::division_by_zero);
+            if (n == numeric_limits<int32_t>::min() and m == -1)
+              return unexpected(parse_error::out_of_range);
+            return n / m;
+          default:
+            return unexpected(parse_error::unknown_operator);
+          }
+        });
+    });
+}
+
+// 比較対象: optional を返す実装 (parse_expr_batch.cpp の parse_expr_view)
+template <integral Int>
+constexpr auto parse_optional(string_view sv) -> optional<Int> {
+  Int n{};
+  auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+  if (ec == errc{} and ptr == sv.data() + sv.size())
+    return n;
+  else
+    return nullopt;
+}
+
+constexpr auto parse_expr_optional(string_view sv) -> optional<int32_t> {
+  const auto lhs = next_token(sv);
+  const auto op = next_token(sv);
+  const auto rhs = next_token(sv);
+  if (op.empty() or rhs.empty())
+    return nullopt;
+  return parse_optional<int32_t>(lhs) //
+    .and_then([&](int32_t n) {
+      return parse_optional<int32_t>(rhs) //
+        .and_then([&](int32_t m) -> optional<int32_t> {
+          switch (op[0]) {
+          case '+':
+            return n + m;
+          case '-':
+            return n - m;
+          case '*':
+            return n * m;
+          case '/':
+            if (m == 0 or (n == numeric_limits<int32_t>::min() and m == -1))
+              return nullopt;
+            return n / m;
+          default:
+            return nullopt;
+          }
+        });
+    });
+}
+
+int main() {
+  assert(parse_expr("1 + 2"sv) == 1 + 2);
+  assert(parse_expr("478 - 234"sv) == 478 - 234);
+  assert(parse_expr("15 * 56"sv) == 15 * 56);
+  assert(parse_expr("98 / 12"sv) == 98 / 12);
+  assert(parse_expr("x + 2"sv).error() == parse_error::invalid_number);
+  assert(parse_expr("1 + 2x"sv).error() == parse_error::invalid_number);
+  assert(parse_expr("99999999999 + 1"sv).error() == parse_error::out_of_range);
+  assert(parse_expr("1 +"sv).error() == parse_error::missing_token);
+  assert(parse_expr(""sv).error() == parse_error::missing_token);
+  assert(parse_expr("1 % 2"sv).error() == parse_error::unknown_operator);
+  assert(parse_expr("98 / 0"sv).error() == parse_error::division_by_zero);
+  assert(parse_expr("-2147483648 / -1"sv).error()
+         == parse_error::out_of_range);
+
+  // 成功する場合の計測: optional と比べて余分なコストがないことを確かめる
+  constexpr size_t n = 1'000'000;
+  vector<string> lines(n);
+  const char* ops = "+-*/";
+  for (size_t i = 0; i < n; ++i)
+    lines[i] = to_string(i % 10007) + ' ' + ops[i % 4] + ' '
+               + to_string(i % 97 + 1);
+  auto lines_per_sec = [&](auto f) {
+    double best = 0;
+    int64_t sum = 0;
+    for (int rep = 0; rep < 5; ++rep) {
+      sum = 0;
+      const auto t0 = chrono::steady_clock::now();
+      for (const auto& line : lines)
+        sum += f(line);
+      const chrono::duration<double> dt = chrono::steady_clock::now() - t0;
+      best = max(best, n / dt.count());
+    }
+    return pair(best, sum);
+  };
+  const auto [r_opt, s_opt] =
+    lines_per_sec([](string_view sv) { return *parse_expr_optional(sv); });
+  const auto [r_exp, s_exp] =
+    lines_per_sec([](string_view sv) { return *parse_expr(sv); });
+  assert(s_opt == s_exp);
+  cout << "optional: " << r_opt << " lines/s\n"
+       << "expected: " << r_exp << " lines/s" << endl;
+
+  // 失敗した場合は理由を表示できる
+  for (auto sv : {"1 +"sv, "1 % 2"sv, "98 / 0"sv})
+    cout << '"' << sv << "\": " << to_string(parse_expr(sv).error()) << '\n';
+}
@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// for main
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+using namespace std; // 見やすさのため
+
+template <integral Int>
+constexpr auto parse(string_view sv) -> optional<Int> {
+  Int n{};
+  auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+  if (ec == errc{} and ptr == sv.data() + sv.size())
+    return n;
+  else
+    return nullopt;
+}
+
+// parse_expr_batch.cpp より
+constexpr auto next_token(string_view& sv) -> string_view {
+  const auto pos = sv.find(' ');
+  const auto tok = sv.substr(0, pos);
+  sv.remove_prefix(pos == string_view::npos ? sv.size() : pos + 1);
+  return tok;
+}
+
+constexpr auto parse_expr_view(string_view sv) -> optional<int32_t> {
+  const auto lhs = next_token(sv);
+  const auto op = next_token(sv);
+  const auto rhs = next_token(sv);
+  if (op.empty())
+    return nullopt;
+  return parse<int32_t>(lhs) //
+    .and_then([&](int32_t n) {
+      return parse<int32_t>(rhs) //
+        .and_then([&](int32_t m) -> optional<int32_t> {
+          int32_t r{};
+          switch (op[0]) {
+          case '+':
+            return __builtin_add_overflow(n, m, &r) ? nullopt : optional(r);
+          case '-':
+            return __builtin_sub_overflow(n, m, &r) ? nullopt : optional(r);
+          case '*':
+            return __builtin_mul_overflow(n, m, &r) ? nullopt : optional(r);
+          case '/':
+            if (m == 0 or (n == numeric_limits<int32_t>::min() and m == -1))
+              return nullopt;
+            return n / m;
+          default:
+            return nullopt;
+          }
+        });
+    });
+}
+
+namespace ns {
+  [[noreturn]] inline void throw_errno(const char* what) {
+    throw system_error(errno, generic_category(), what);
+  }
+
+  /// 結果を 2 つのファイルに書き出す
+  /// - <path>.values:   int32_t の列 (ネイティブエンディアン)。無効な行は 0
+  /// - <path>.validity: 有効性ビットマップ (Arrow 形式: LSB から順に 1 bit/行)
+  struct column_writer {
+  private:
+    FILE* values_ = nullptr;
+    FILE* validity_ = nullptr;
+    uint8_t pending_ = 0; // 書き出していないビットマップの端数
+    int npending_ = 0;
+    size_t rows_ = 0;
+
+  public:
+    explicit column_writer(const string& path)
+      : values_(fopen((path + ".values").c_str(), "wb")),
+        validity_(fopen((path + ".validity").c_str(), "wb")) {
+      if (not values_ or not validity_) {
+        const int e = errno;
+        close();
+        errno = e;
+        throw_errno("column_writer");
+      }
+    }
+    column_writer(const column_writer&) = delete;
+    column_writer& operator=(const column_writer&) = delete;
+    ~column_writer() { close(); }
+
+    void append(span<const int32_t> values, span<const uint8_t> valid) {
+      if (fwrite(values.data(), sizeof(int32_t), values.size(), values_)
+          != values.size())
+        throw_errno("fwrite");
+      vector<uint8_t> bytes;
+      bytes.reserve(valid.size() / 8 + 1);
+      for (uint8_t v : valid) {
+        pending_ |= static_cast<uint8_t>(v << npending_);
+        if (++npending_ == 8) {
+          bytes.push_back(pending_);
+          pending_ = 0;
+          npending_ = 0;
+        }
+      }
+      if (fwrite(bytes.data(), 1, bytes.size(), validity_) != bytes.size())
+        throw_errno("fwrite");
+      rows_ += values.size();
+    }
+
+    size_t rows() const noexcept { return rows_; }
+
+    void finish() {
+      if (npending_ != 0 and fputc(pending_, validity_) == EOF)
+        throw_errno("fputc");
+      npending_ = 0;
+      if (fflush(values_) != 0 or fflush(validity_) != 0)
+        throw_errno("fflush");
+    }
+
+  private:
+    void close() noexcept {
+      if (values_)
+        fclose(exchange(values_, nullptr));
+      if (validity_)
+        fclose(exchange(validity_, nullptr));
+    }
+  };
+
+  // [first, last) の行を評価する。last は改行の直後か入力の終端を指す
+  inline void eval_lines(const char* first, const char* last,
+                         vector<int32_t>& values, vector<uint8_t>& valid) {
+    while (first != last) {
+      const void* nl = memchr(first, '\n', static_cast<size_t>(last - first));
+      const char* eol = nl ? static_cast<const char*>(nl) : last;
+      const auto r = parse_expr_view(string_view(first, eol));
+      values.push_back(r.value_or(0));
+      valid.push_back(r.has_value());
+      first = nl ? eol + 1 : last;
+    }
+  }
+
+  // ウィンドウを行境界でスレッド数に分割して並列に評価し、順に書き出す
+  inline void eval_window(string_view window, column_writer& out,
+                          unsigned nthreads) {
+    vector<const char*> bounds{window.data()};
+    const char* const end = window.data() + window.size();
+    for (unsigned i = 1; i < nthreads; ++i) {
+      const char* p =
+        max(bounds.back(), window.data() + window.size() * i / nthreads);
+      const void* nl = memchr(p, '\n', static_cast<size_t>(end - p));
+      bounds.push_back(nl ? static_cast<const char*>(nl) + 1 : end);
+    }
+    bounds.push_back(end);
+
+    const size_t nparts = bounds.size() - 1;
+    vector<vector<int32_t>> values(nparts);
+    vector<vector<uint8_t>> valid(nparts);
+    {
+      vector<jthread> workers;
+      for (size_t i = 1; i < nparts; ++i)
+        workers.emplace_back(eval_lines, bounds[i], bounds[i + 1],
+                             ref(values[i]), ref(valid[i]));
+      eval_lines(bounds[0], bounds[1], values[0], valid[0]);
+    } // join
+    for (size_t i = 0; i < nparts; ++i)
+      out.append(values[i], valid[i]);
+  }
+
+  struct file_options {
+    //! 1 度に処理するバイト数。常駐メモリはおよそこの大きさに比例する
+    size_t window_size = size_t{64} << 20;
+    unsigned nthreads = max(thread::hardware_concurrency(), 1u);
+    //! mmap を用いず read で読み込む
+    bool force_read = false;
+  };
+
+  /// 1 行 1 式のテキストファイルを評価し、結果を列形式で書き出す
+  /// 入力を mmap し、処理済みの範囲は madvise で解放するため、
+  /// ファイルの大きさによらず常駐メモリは window_size 程度に収まる
+  /// mmap できない場合 (パイプなど) は window_size ずつ read する
+  inline size_t eval_file(const string& input, const string& output,
+                          const file_options& opt = {}) {
+    const int fd = ::open(input.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw_errno("open");
+    struct fd_guard {
+      int fd;
+      ~fd_guard() { ::close(fd); }
+    } guard{fd};
+
+    column_writer out(output);
+    struct stat st{};
+    if (fstat(fd, &st) != 0)
+      throw_errno("fstat");
+    const size_t size = static_cast<size_t>(st.st_size);
+
+    void* map = MAP_FAILED;
+    if (not opt.force_read and S_ISREG(st.st_mode) and size != 0)
+      map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map != MAP_FAILED) {
+      const char* const base = static_cast<const char*>(map);
+      madvise(map, size, MADV_SEQUENTIAL);
+      const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+      size_t off = 0, released = 0;
+      while (off < size) {
+        // ウィンドウの終端を次の改行の直後まで延ばす
+        size_t last = min(off + opt.window_size, size);
+        if (last < size) {
+          const void* nl = memchr(base + last, '\n', size - last);
+          last = nl ? static_cast<const char*>(nl) - base + 1 : size;
+        }
+        eval_window(string_view(base + off, last - off), out, opt.nthreads);
+        off = last;
+        // 処理済みのページを常駐メモリから外す
+        const size_t upto = off / page * page;
+        if (upto > released) {
+          madvise(const_cast<char*>(base) + released, upto - released,
+                  MADV_DONTNEED);
+          released = upto;
+        }
+      }
+      munmap(map, size);
+    } else {
+      vector<char> buf(opt.window_size);
+      size_t filled = 0;
+      bool eof = false;
+      while (not eof or filled != 0) {
+        // パイプなどは 1 回の read で短く返るので、バッファが満ちるか EOF まで読み続ける
+        while (not eof and filled != buf.size()) {
+          const ssize_t n =
+            ::read(fd, buf.data() + filled, buf.size() - filled);
+          if (n < 0) {
+            if (errno == EINTR)
+              continue;
+            throw_errno("read");
+          }
+          eof = n == 0;
+          filled += static_cast<size_t>(n);
+        }
+        // 最後の改行までを評価し、残りは次のウィンドウに持ち越す
+        const string_view data(buf.data(), filled);
+        const size_t nl = data.rfind('\n');
+        const size_t complete =
+          eof ? filled : (nl == string_view::npos ? 0 : nl + 1);
+        if (complete == 0) {
+          buf.resize(buf.size() * 2); // 1 行がウィンドウより長い場合
+          continue;
+        }
+        eval_window(data.substr(0, complete), out, opt.nthreads);
+        memmove(buf.data(), buf.data() + complete, filled - complete);
+        filled -= complete;
+      }
+    }
+    out.finish();
+    return out.rows();
+  }
+} // namespace ns
+
+int main(int argc, char** argv) {
+  if (argc == 3) {
+    const auto t0 = chrono::steady_clock::now();
+    const size_t rows = ns::eval_file(argv[1], argv[2]);
+    const chrono::duration<double> dt = chrono::steady_clock::now() - t0;
+    cout << rows << " lines, " << rows / dt.count() << " lines/s" << endl;
+    return 0;
+  }
+
+  // 引数がない場合は一時ファイルで動作を確認する
+  const auto dir = filesystem::temp_directory_path();
+  const string input = dir / "parse_expr_file_input.txt";
+  const string output = dir / "parse_expr_file_output";
+  constexpr size_t n = 100'003;
+  {
+    ofstream ofs(input);
+    const char* ops = "+-*/%";
+    for (size_t i = 0; i < n; ++i)
+      ofs << i % 1000 << ' ' << ops[i % 5] << ' ' << i % 7 << '\n';
+  }
+  auto check = [&](const ns::file_options& opt, const string& path) {
+    assert(ns::eval_file(path, output, opt) == n);
+    ifstream values(output + ".values", ios::binary);
+    ifstream validity(output + ".validity", ios::binary);
+    vector<char> bits((n + 7) / 8);
+    validity.read(bits.data(), static_cast<streamsize>(bits.size()));
+    assert(validity.gcount() == static_cast<streamsize>(bits.size()));
+    ifstream lines(input);
+    string line;
+    for (size_t i = 0; getline(lines, line); ++i) {
+      int32_t v;
+      values.read(reinterpret_cast<char*>(&v), sizeof(v));
+      const auto expected = parse_expr_view(line);
+      assert(((bits[i / 8] >> (i % 8)) & 1) == expected.has_value());
+      assert(v == expected.value_or(0));
+    }
+  };
+  // ウィンドウ境界・スレッド分割・read による読み込みを小さいサイズで確認する
+  check({.window_size = 4096, .nthreads = 3}, input);
+  check({.window_size = 4096, .nthreads = 3, .force_read = true}, input);
+  check({.window_size = 7, .nthreads = 1, .force_read = true}, input);
+  check({}, input);
+  // パイプからの読み込み (mmap できず、read が短く返る)
+  {
+    const string fifo = dir / "parse_expr_file_fifo";
+    filesystem::remove(fifo);
+    if (mkfifo(fifo.c_str(), 0600) != 0)
+      ns::throw_errno("mkfifo");
+    jthread writer([&] { ofstream(fifo) << ifstream(input).rdbuf(); });
+    check({.window_size = 1 << 20, .nthreads = 3}, fifo);
+    filesystem::remove(fifo);
+  }
+  filesystem::remove(input);
+  filesystem::remove(output + ".values");
+  filesystem::remove(output + ".validity");
+}
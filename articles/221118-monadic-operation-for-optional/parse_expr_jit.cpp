@@ -0,0 +1,447 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) and defined(__linux__)
+#define NS_JIT_AVAILABLE 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define NS_JIT_AVAILABLE 0
+#endif
+// for main
+#include <chrono>
+#include <iostream>
+using namespace std; // 見やすさのため
+
+template <integral Int>
+constexpr auto parse(string_view sv) -> optional<Int> {
+  Int n{};
+  auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+  if (ec == errc{} and ptr == sv.data() + sv.size())
+    return n;
+  else
+    return nullopt;
+}
+
+// 従来の実装
+constexpr auto parse_expr(string_view sv) {
+  const auto toks = sv | views::split(' ') | ranges::to<vector>();
+  return parse<int32_t>(string_view(toks[0])) //
+    .and_then([&](int32_t n) {
+      return parse<int32_t>(string_view(toks[2]))
+        .and_then([&](int32_t m) -> optional<int32_t> {
+          switch (toks[1][0]) {
+          case '+':
+            return n + m;
+          case '-':
+            return n - m;
+          case '*':
+            return n * m;
+          case '/':
+            return n / m;
+          default:
+            return nullopt;
+          }
+        });
+    });
+}
+
+// parse_expr_batch.cpp より
+constexpr auto next_token(string_view& sv) -> string_view {
+  const auto pos = sv.find(' ');
+  const auto tok = sv.substr(0, pos);
+  sv.remove_prefix(pos == string_view::npos ? sv.size() : pos + 1);
+  return tok;
+}
+
+namespace ns {
+  // 式のテンプレート "$0 * 3 + $1" の被演算子。整数リテラルか $n (n 番目の引数)
+  struct operand {
+    bool is_arg;
+    int32_t value; // is_arg の場合は引数の番号
+  };
+
+  inline constexpr int32_t max_args = 1 << 16;
+
+  constexpr auto parse_operand(string_view tok) -> optional<operand> {
+    if (tok.starts_with('$'))
+      return parse<int32_t>(tok.substr(1))
+        .and_then([](int32_t n) -> optional<operand> {
+          if (n < 0 or n >= max_args)
+            return nullopt;
+          return operand{true, n};
+        });
+    return parse<int32_t>(tok).transform(
+      [](int32_t n) { return operand{false, n}; });
+  }
+
+  constexpr auto is_operator(string_view tok) -> bool {
+    return tok.size() == 1 and "+-*/"sv.contains(tok[0]);
+  }
+
+  // 二項演算。0 除算と INT32_MIN / -1 は nullopt、それ以外の溢れは折り返す
+  constexpr auto apply(char op, int32_t n, int32_t m) -> optional<int32_t> {
+    const auto un = static_cast<uint32_t>(n), um = static_cast<uint32_t>(m);
+    switch (op) {
+    case '+':
+      return static_cast<int32_t>(un + um);
+    case '-':
+      return static_cast<int32_t>(un - um);
+    case '*':
+      return static_cast<int32_t>(un * um);
+    default:
+      if (m == 0 or (n == numeric_limits<int32_t>::min() and m == -1))
+        return nullopt;
+      return n / m;
+    }
+  }
+
+  /// テンプレートを左から順に解釈して評価する
+  /// 構文が正しくない場合と引数が足りない場合も nullopt を返す
+  constexpr auto interpret(string_view sv, span<const int32_t> args)
+    -> optional<int32_t> {
+    auto value = [&](operand o) -> optional<int32_t> {
+      if (not o.is_arg)
+        return o.value;
+      if (static_cast<size_t>(o.value) >= args.size())
+        return nullopt;
+      return args[static_cast<size_t>(o.value)];
+    };
+    auto acc = parse_operand(next_token(sv)).and_then(value);
+    while (acc and not sv.empty()) {
+      const auto op = next_token(sv);
+      if (not is_operator(op))
+        return nullopt;
+      acc = parse_operand(next_token(sv))
+              .and_then(value)
+              .and_then([&](int32_t m) { return apply(op[0], *acc, m); });
+    }
+    return acc;
+  }
+} // namespace ns
+
+namespace ns::jit {
+  // 穴 (hole) を持つ機械語の断片。値の穴には即値か引数の変位 (4 * n) を、
+  // 失敗の穴には失敗時の出口への rel32 を書き込む
+  struct stencil {
+    array<uint8_t, 40> bytes{};
+    uint8_t size = 0;
+    int8_t value_hole = -1;
+    array<int8_t, 2> fail_holes{-1, -1};
+  };
+
+  // 生成する関数: bool f(const int32_t* args /* rdi */, int32_t* out /* rsi */)
+  // 累算器は eax
+  namespace stencils {
+    // mov eax, [rdi + disp32]
+    inline constexpr stencil load_arg{{0x8B, 0x87, 0, 0, 0, 0}, 6, 2};
+    // mov eax, imm32
+    inline constexpr stencil load_imm{{0xB8, 0, 0, 0, 0}, 5, 1};
+    // add eax, [rdi + disp32] / add eax, imm32
+    inline constexpr stencil add_arg{{0x03, 0x87, 0, 0, 0, 0}, 6, 2};
+    inline constexpr stencil add_imm{{0x05, 0, 0, 0, 0}, 5, 1};
+    // sub eax, [rdi + disp32] / sub eax, imm32
+    inline constexpr stencil sub_arg{{0x2B, 0x87, 0, 0, 0, 0}, 6, 2};
+    inline constexpr stencil sub_imm{{0x2D, 0, 0, 0, 0}, 5, 1};
+    // imul eax, [rdi + disp32] / imul eax, eax, imm32
+    inline constexpr stencil mul_arg{{0x0F, 0xAF, 0x87, 0, 0, 0, 0}, 7, 3};
+    inline constexpr stencil mul_imm{{0x69, 0xC0, 0, 0, 0, 0}, 6, 2};
+    // mov ecx, [rdi + disp32]
+    // test ecx, ecx;              jz fail
+    // cmp ecx, -1;                jne L
+    // cmp eax, 0x80000000;        je fail
+    // L: cdq; idiv ecx
+    inline constexpr stencil div_arg{
+      {
+        0x8B, 0x8F, 0, 0, 0, 0,             //
+        0x85, 0xC9, 0x0F, 0x84, 0, 0, 0, 0, //
+        0x83, 0xF9, 0xFF, 0x75, 0x0B,       //
+        0x3D, 0x00, 0x00, 0x00, 0x80,       //
+        0x0F, 0x84, 0, 0, 0, 0,             //
+        0x99, 0xF7, 0xF9,                   //
+      },
+      33,
+      2,
+      {10, 26},
+    };
+    // 除数が 0 でも -1 でもない定数の場合は検査しない
+    // mov ecx, imm32; cdq; idiv ecx
+    inline constexpr stencil div_imm{
+      {0xB9, 0, 0, 0, 0, 0x99, 0xF7, 0xF9}, 8, 1};
+    // x / -1: cmp eax, 0x80000000; je fail; neg eax
+    inline constexpr stencil neg{
+      {0x3D, 0x00, 0x00, 0x00, 0x80, 0x0F, 0x84, 0, 0, 0, 0, 0xF7, 0xD8},
+      13,
+      -1,
+      {7, -1},
+    };
+    // x / 0: jmp fail
+    inline constexpr stencil fail{{0xE9, 0, 0, 0, 0}, 5, -1, {1, -1}};
+    // mov [rsi], eax; mov eax, 1; ret
+    inline constexpr stencil ret{
+      {0x89, 0x06, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3}, 8};
+    // fail: xor eax, eax; ret
+    inline constexpr stencil fail_exit{{0x31, 0xC0, 0xC3}, 3};
+  } // namespace stencils
+
+  // 断片を複写して穴を埋める
+  struct assembler {
+    vector<uint8_t> buf;
+    vector<size_t> fail_patches;
+
+    void emit(const stencil& s, int32_t value = 0) {
+      const size_t base = buf.size();
+      buf.insert(buf.end(), s.bytes.begin(), s.bytes.begin() + s.size);
+      if (s.value_hole >= 0)
+        memcpy(buf.data() + base + s.value_hole, &value, sizeof(value));
+      for (int8_t h : s.fail_holes)
+        if (h >= 0)
+          fail_patches.push_back(base + static_cast<size_t>(h));
+    }
+
+    // 失敗時の出口を末尾に置き、rel32 を解決する
+    vector<uint8_t> finish() && {
+      emit(stencils::ret);
+      const size_t exit = buf.size();
+      emit(stencils::fail_exit);
+      for (size_t hole : fail_patches) {
+        const auto rel = static_cast<int32_t>(exit - (hole + 4));
+        memcpy(buf.data() + hole, &rel, sizeof(rel));
+      }
+      return std::move(buf);
+    }
+  };
+
+  // 演算子と被演算子の種類から断片を選ぶ
+  inline void emit_binop(assembler& as, char op, operand rhs) {
+    const int32_t v = rhs.is_arg ? rhs.value * 4 : rhs.value;
+    switch (op) {
+    case '+':
+      return as.emit(rhs.is_arg ? stencils::add_arg : stencils::add_imm, v);
+    case '-':
+      return as.emit(rhs.is_arg ? stencils::sub_arg : stencils::sub_imm, v);
+    case '*':
+      return as.emit(rhs.is_arg ? stencils::mul_arg : stencils::mul_imm, v);
+    default:
+      if (rhs.is_arg)
+        return as.emit(stencils::div_arg, v);
+      if (v == 0)
+        return as.emit(stencils::fail);
+      if (v == -1)
+        return as.emit(stencils::neg);
+      return as.emit(stencils::div_imm, v);
+    }
+  }
+
+  /// mmap した実行可能領域。書き込み後に mprotect で実行のみに切り替える
+  struct executable_code {
+  private:
+    void* p_ = nullptr;
+    size_t size_ = 0;
+
+  public:
+    using fn_t = bool (*)(const int32_t* args, int32_t* out);
+
+    executable_code() = default;
+    executable_code(executable_code&& other) noexcept
+      : p_(exchange(other.p_, nullptr)), size_(exchange(other.size_, 0)) {}
+    executable_code& operator=(executable_code other) noexcept {
+      swap(p_, other.p_);
+      swap(size_, other.size_);
+      return *this;
+    }
+    ~executable_code() {
+#if NS_JIT_AVAILABLE
+      if (p_)
+        munmap(p_, size_);
+#endif
+    }
+
+    // 失敗した場合は nullopt を返す
+    static optional<executable_code> load(span<const uint8_t> code) {
+#if NS_JIT_AVAILABLE
+      const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+      executable_code ec;
+      ec.size_ = (code.size() + page - 1) / page * page;
+      void* p = mmap(nullptr, ec.size_, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED)
+        return nullopt;
+      ec.p_ = p;
+      memcpy(p, code.data(), code.size());
+      if (mprotect(p, ec.size_, PROT_READ | PROT_EXEC) != 0)
+        return nullopt;
+      return ec;
+#else
+      (void)code;
+      return nullopt;
+#endif
+    }
+
+    fn_t get() const noexcept { return reinterpret_cast<fn_t>(p_); }
+  };
+
+  enum class backend { interpreter, native };
+
+  /// テンプレートを 1 度だけ検査し、評価を繰り返す
+  /// backend::native を指定すると x86-64 Linux ではネイティブコードを生成し、
+  /// 生成できない環境やテンプレートではインタプリタで評価する
+  struct compiled_expr {
+  private:
+    string tmpl_;
+    size_t arity_ = 0;
+    executable_code code_;
+
+    compiled_expr() = default;
+
+  public:
+    /// 構文が正しくない場合は nullopt を返す
+    static optional<compiled_expr> compile(string_view sv,
+                                           backend b = backend::interpreter) {
+      compiled_expr e;
+      e.tmpl_ = sv;
+      assembler as;
+      auto arg = [&](operand o) {
+        if (o.is_arg)
+          e.arity_ = max(e.arity_, static_cast<size_t>(o.value) + 1);
+        return o;
+      };
+      const auto first = parse_operand(next_token(sv)).transform(arg);
+      if (not first)
+        return nullopt;
+      as.emit(first->is_arg ? stencils::load_arg : stencils::load_imm,
+              first->is_arg ? first->value * 4 : first->value);
+      while (not sv.empty()) {
+        const auto op = next_token(sv);
+        const auto rhs = parse_operand(next_token(sv)).transform(arg);
+        if (not is_operator(op) or not rhs)
+          return nullopt;
+        emit_binop(as, op[0], *rhs);
+      }
+      if (b == backend::native)
+        if (auto code = executable_code::load(std::move(as).finish()))
+          e.code_ = std::move(*code);
+      return e;
+    }
+
+    bool is_native() const noexcept { return code_.get() != nullptr; }
+    size_t arity() const noexcept { return arity_; }
+
+    optional<int32_t> operator()(span<const int32_t> args) const {
+      if (not is_native())
+        return interpret(tmpl_, args);
+      if (args.size() < arity_)
+        return nullopt;
+      int32_t out;
+      if (code_.get()(args.data(), &out))
+        return out;
+      return nullopt;
+    }
+  };
+} // namespace ns::jit
+
+int main() {
+  using ns::jit::backend;
+  using ns::jit::compiled_expr;
+
+  // ネイティブコードとインタプリタの結果を突き合わせる
+  const string_view templates[]{
+    "$0 + $1", "$0 - $1", "$0 * $1",
+    "$0 / $1", "$0 / 7",  "$0 / -1",
+    "$0 / 0",  "98 / 12", "$1 * 3 + $0 - 5 / $1",
+    "-5 * $0 - 2147483647",
+  };
+  const int32_t values[]{
+    0, 1, -1, 7, -13, 1000,
+    numeric_limits<int32_t>::min(),
+    numeric_limits<int32_t>::max(),
+  };
+  for (auto t : templates) {
+    const auto native = compiled_expr::compile(t, backend::native).value();
+    const auto interp = compiled_expr::compile(t).value();
+    assert(native.is_native() == bool(NS_JIT_AVAILABLE));
+    assert(not interp.is_native());
+    for (int32_t a : values)
+      for (int32_t b : values) {
+        const int32_t args[]{a, b};
+        assert(native(args) == interp(args));
+      }
+    const int32_t few[]{1};
+    assert(native.arity() <= 1 or native(few) == nullopt);
+  }
+  {
+    const int32_t args[]{4, 7};
+    const auto e = compiled_expr::compile("$0 * 3 + $1", backend::native);
+    assert((*e)(args) == optional(4 * 3 + 7));
+  }
+  assert(not compiled_expr::compile(""));
+  assert(not compiled_expr::compile("1 +"));
+  assert(not compiled_expr::compile("1 % 2"));
+  assert(not compiled_expr::compile("$x + 1"));
+
+  using clock = chrono::steady_clock;
+  const string_view ops = "+-*/";
+
+  // コンパイルの所要時間 (mmap と mprotect を含む)
+  {
+    constexpr int reps = 10'000;
+    int compiled = 0;
+    const auto t0 = clock::now();
+    for (int i = 0; i < reps; ++i)
+      compiled += compiled_expr::compile("$0 * 3 + $1", backend::native)
+                    .transform(&compiled_expr::is_native)
+                    .value_or(false);
+    const chrono::duration<double, micro> dt = clock::now() - t0;
+    assert(compiled == (NS_JIT_AVAILABLE ? reps : 0));
+    cout << "native compile: " << dt.count() / reps << " us/expr\n";
+  }
+
+  // 繰り返し評価の計測
+  constexpr size_t n = 1'000'000;
+  vector<array<int32_t, 2>> args(n);
+  vector<string> lines(n);
+  for (size_t i = 0; i < n; ++i) {
+    args[i] = {static_cast<int32_t>(i % 10007),
+               static_cast<int32_t>(i % 97 + 1)};
+    lines[i] = to_string(args[i][0]) + ' ' + ops[i % 4] + ' '
+               + to_string(args[i][1]);
+  }
+  vector<compiled_expr> interp, native;
+  for (char op : ops) {
+    const auto t = string("$0 ") + op + " $1";
+    interp.push_back(compiled_expr::compile(t).value());
+    native.push_back(compiled_expr::compile(t, backend::native).value());
+  }
+  auto evals_per_sec = [&](auto f) {
+    int64_t sum = 0;
+    const auto t0 = clock::now();
+    for (size_t i = 0; i < n; ++i)
+      sum += f(i).value_or(0);
+    const double rate =
+      n / chrono::duration<double>(clock::now() - t0).count();
+    return pair(rate, sum);
+  };
+  const auto [r_expr, s_expr] =
+    evals_per_sec([&](size_t i) { return parse_expr(lines[i]); });
+  const auto [r_interp, s_interp] =
+    evals_per_sec([&](size_t i) { return interp[i % 4](args[i]); });
+  const auto [r_native, s_native] =
+    evals_per_sec([&](size_t i) { return native[i % 4](args[i]); });
+  assert(s_expr == s_native and s_interp == s_native);
+  cout << "parse_expr:  " << r_expr << " evals/s\n"
+       << "interpreter: " << r_interp << " evals/s\n"
+       << "native:      " << r_native << " evals/s" << endl;
+}
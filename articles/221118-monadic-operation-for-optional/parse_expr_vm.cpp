@@ -0,0 +1,422 @@
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <vector>
+// for main
+#include <chrono>
+#include <iostream>
+#include <string>
+using namespace std; // 見やすさのため
+
+template <integral Int>
+constexpr auto parse(string_view sv) -> optional<Int> {
+  Int n{};
+  auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+  if (ec == errc{} and ptr == sv.data() + sv.size())
+    return n;
+  else
+    return nullopt;
+}
+
+// 従来の実装: 評価のたびに字句解析と演算子の選択を行う
+constexpr auto parse_expr(string_view sv) {
+  const auto toks = sv | views::split(' ') | ranges::to<vector>();
+  return parse<int32_t>(string_view(toks[0])) //
+    .and_then([&](int32_t n) {
+      return parse<int32_t>(string_view(toks[2]))
+        .and_then([&](int32_t m) -> optional<int32_t> {
+          switch (toks[1][0]) {
+          case '+':
+            return n + m;
+          case '-':
+            return n - m;
+          case '*':
+            return n * m;
+          case '/':
+            return n / m;
+          default:
+            return nullopt;
+          }
+        });
+    });
+}
+
+// parse_expr_batch.cpp より
+constexpr auto next_token(string_view& sv) -> string_view {
+  const auto pos = sv.find(' ');
+  const auto tok = sv.substr(0, pos);
+  sv.remove_prefix(pos == string_view::npos ? sv.size() : pos + 1);
+  return tok;
+}
+
+constexpr auto parse_expr_view(string_view sv) -> optional<int32_t> {
+  const auto lhs = next_token(sv);
+  const auto op = next_token(sv);
+  const auto rhs = next_token(sv);
+  if (op.empty())
+    return nullopt;
+  return parse<int32_t>(lhs) //
+    .and_then([&](int32_t n) {
+      return parse<int32_t>(rhs) //
+        .and_then([&](int32_t m) -> optional<int32_t> {
+          switch (op[0]) {
+          case '+':
+            return n + m;
+          case '-':
+            return n - m;
+          case '*':
+            return n * m;
+          case '/':
+            if (m == 0 or (n == numeric_limits<int32_t>::min() and m == -1))
+              return nullopt;
+            return n / m;
+          default:
+            return nullopt;
+          }
+        });
+    });
+}
+
+#if defined(__GNUC__)
+#define NS_VM_THREADED 1
+#else
+#define NS_VM_THREADED 0
+#endif
+
+namespace ns::vm {
+  enum class opcode : uint8_t {
+    load_arg,    // reg[dst] = args[imm]
+    load_imm,    // reg[dst] = imm
+    add,         // reg[dst] = reg[lhs] + reg[rhs]
+    sub,
+    mul,
+    div,         // 未観測の除算。初回の実行時に除数を観測し、以下のいずれかに書き換えられる
+    div_pos,     // 除数が正であると推測した除算。推測が外れると div_checked に書き換えられる
+    div_checked, // 0 除算と INT32_MIN / -1 を検査する。以後は書き換えられない
+    add_imm,     // reg[dst] = reg[lhs] + imm
+    sub_imm,
+    mul_imm,
+    div_imm, // imm は 0 でも -1 でもないため検査しない
+    neg,     // x / -1 。INT32_MIN のみ検査する
+    fail,    // x / 0
+    ret,     // return reg[lhs]
+  };
+
+  struct instr {
+    opcode op = opcode::fail;
+    uint8_t dst = 0, lhs = 0, rhs = 0; // レジスタ番号
+    int32_t imm = 0;
+  };
+
+  inline constexpr size_t max_registers = 16;
+
+  // 演算子と右辺から、コンパイル時に定まる範囲で二項演算の命令を選ぶ
+  // 右辺が即値の場合は、その値に応じた検査のみを行う命令を選ぶ
+  constexpr opcode select_binop(char oper, bool rhs_is_imm, int32_t imm) noexcept {
+    if (not rhs_is_imm) {
+      switch (oper) {
+      case '+':
+        return opcode::add;
+      case '-':
+        return opcode::sub;
+      case '*':
+        return opcode::mul;
+      default:
+        return opcode::div;
+      }
+    }
+    switch (oper) {
+    case '+':
+      return opcode::add_imm;
+    case '-':
+      return opcode::sub_imm;
+    case '*':
+      return opcode::mul_imm;
+    default:
+      return imm == 0    ? opcode::fail
+             : imm == -1 ? opcode::neg
+                         : opcode::div_imm;
+    }
+  }
+
+  /// 式のテンプレートをコンパイルしたバイトコード
+  /// 右辺がレジスタの除算は、実行時に観測した除数に基づいて命令を書き換える (quickening) ため、
+  /// 同じ program を複数のスレッドから同時に評価してはならない
+  struct program {
+  private:
+    vector<instr> code_;
+    size_t arity_ = 0;
+
+    program() = default;
+
+  public:
+    /// "$0 * 3 + $1" のような、' ' で区切られた被演算子と演算子の列をコンパイルする
+    /// 被演算子は整数リテラルか $n (n 番目の引数) で、演算は左から順に行う
+    /// 構文が正しくない場合は nullopt を返す
+    static optional<program> compile(string_view sv) {
+      program p;
+      // r0 を累算器とし、$n はレジスタ n + 1 に読み込む
+      array<bool, max_registers> loaded{};
+      struct operand_t {
+        bool is_imm;
+        uint8_t reg;
+        int32_t imm;
+      };
+      auto operand = [&](string_view tok) -> optional<operand_t> {
+        if (tok.starts_with('$')) {
+          const auto n = parse<uint8_t>(tok.substr(1));
+          if (not n or *n + 1u >= max_registers)
+            return nullopt;
+          const auto r = static_cast<uint8_t>(*n + 1);
+          if (not loaded[r]) {
+            // 引数の読み込みは先頭にまとめる
+            p.code_.insert(p.code_.begin(),
+                           instr{.op = opcode::load_arg, .dst = r, .imm = *n});
+            loaded[r] = true;
+            p.arity_ = max(p.arity_, size_t{*n} + 1);
+          }
+          return operand_t{.is_imm = false, .reg = r, .imm = 0};
+        }
+        return parse<int32_t>(tok).transform([](int32_t imm) {
+          return operand_t{.is_imm = true, .reg = 0, .imm = imm};
+        });
+      };
+
+      const auto first = operand(next_token(sv));
+      if (not first)
+        return nullopt;
+      // 先頭の被演算子を r0 に置く (レジスタからは add_imm 0 で複写する)
+      p.code_.push_back(first->is_imm
+                          ? instr{.op = opcode::load_imm, .imm = first->imm}
+                          : instr{.op = opcode::add_imm, .lhs = first->reg});
+      while (not sv.empty()) {
+        const auto op = next_token(sv);
+        if (op.size() != 1 or not "+-*/"sv.contains(op[0]))
+          return nullopt;
+        const auto rhs = operand(next_token(sv));
+        if (not rhs)
+          return nullopt;
+        p.code_.push_back({.op = select_binop(op[0], rhs->is_imm, rhs->imm),
+                           .rhs = rhs->reg,
+                           .imm = rhs->imm});
+      }
+      p.code_.push_back({.op = opcode::ret});
+      return p;
+    }
+
+    size_t arity() const noexcept { return arity_; }
+    span<const instr> code() const noexcept { return code_; }
+
+    optional<int32_t> operator()(span<const int32_t> args) {
+      if (args.size() < arity_)
+        return nullopt;
+      int32_t reg[max_registers]{};
+      instr* pc = code_.data();
+
+#if NS_VM_THREADED
+      // opcode の順に並べる
+      static constexpr void* labels[]{
+        &&L_load_arg, &&L_load_imm, &&L_add,     &&L_sub,
+        &&L_mul,      &&L_div,      &&L_div_pos, &&L_div_checked,
+        &&L_add_imm,  &&L_sub_imm,  &&L_mul_imm, &&L_div_imm,
+        &&L_neg,      &&L_fail,     &&L_ret,
+      };
+#define NS_VM_CASE(name) L_##name:
+#define NS_VM_NEXT() goto* labels[static_cast<size_t>(pc->op)]
+      NS_VM_NEXT();
+#else
+#define NS_VM_CASE(name) case opcode::name:
+#define NS_VM_NEXT() continue
+      for (;;)
+        switch (pc->op) {
+#endif
+      NS_VM_CASE(load_arg) {
+        reg[pc->dst] = args[static_cast<size_t>(pc->imm)];
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(load_imm) {
+        reg[pc->dst] = pc->imm;
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(add) {
+        reg[pc->dst] = reg[pc->lhs] + reg[pc->rhs];
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(sub) {
+        reg[pc->dst] = reg[pc->lhs] - reg[pc->rhs];
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(mul) {
+        reg[pc->dst] = reg[pc->lhs] * reg[pc->rhs];
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(div) {
+        // 除数を観測して書き換え、pc を進めずに実行し直す
+        pc->op = reg[pc->rhs] > 0 ? opcode::div_pos : opcode::div_checked;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(div_pos) {
+        // 除数が正であれば、0 除算も INT32_MIN / -1 も起こらない
+        if (reg[pc->rhs] <= 0) {
+          // 推測が外れた: 検査付きの命令に戻し、実行し直す
+          pc->op = opcode::div_checked;
+          NS_VM_NEXT();
+        }
+        reg[pc->dst] = reg[pc->lhs] / reg[pc->rhs];
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(div_checked) {
+        const int32_t n = reg[pc->lhs], m = reg[pc->rhs];
+        if (m == 0 or (n == numeric_limits<int32_t>::min() and m == -1))
+          return nullopt;
+        reg[pc->dst] = n / m;
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(add_imm) {
+        reg[pc->dst] = reg[pc->lhs] + pc->imm;
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(sub_imm) {
+        reg[pc->dst] = reg[pc->lhs] - pc->imm;
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(mul_imm) {
+        reg[pc->dst] = reg[pc->lhs] * pc->imm;
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(div_imm) {
+        reg[pc->dst] = reg[pc->lhs] / pc->imm;
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(neg) {
+        if (reg[pc->lhs] == numeric_limits<int32_t>::min())
+          return nullopt;
+        reg[pc->dst] = -reg[pc->lhs];
+        ++pc;
+        NS_VM_NEXT();
+      }
+      NS_VM_CASE(fail) { return nullopt; }
+      NS_VM_CASE(ret) { return reg[pc->lhs]; }
+#if not NS_VM_THREADED
+        }
+#endif
+#undef NS_VM_CASE
+#undef NS_VM_NEXT
+    }
+  };
+} // namespace ns::vm
+
+int main() {
+  using ns::vm::opcode;
+  using ns::vm::program;
+
+  {
+    auto p = program::compile("$0 + $1").value();
+    assert(p.arity() == 2);
+    assert(p.code().end()[-2].op == opcode::add);
+    const int32_t args[]{1, 2};
+    assert(p(args) == optional(1 + 2));
+    const int32_t args2[]{478, 234};
+    assert(p(args2) == optional(478 + 234));
+  }
+  {
+    // 除数が正であることを観測すると、検査を省いた命令に書き換えられる
+    auto p = program::compile("$0 / $1").value();
+    assert(p.code().end()[-2].op == opcode::div);
+    const int32_t args[]{7, 2};
+    assert(p(args) == optional(7 / 2));
+    assert(p.code().end()[-2].op == opcode::div_pos);
+    // 推測が外れると検査付きの命令に戻り、以後は書き換えられない
+    const int32_t zero[]{7, 0}, min[]{numeric_limits<int32_t>::min(), -1};
+    assert(p(zero) == nullopt);
+    assert(p.code().end()[-2].op == opcode::div_checked);
+    assert(p(args) == optional(7 / 2));
+    assert(p(min) == nullopt);
+    assert(p.code().end()[-2].op == opcode::div_checked);
+    // 最初に観測した除数が正でない場合
+    auto q = program::compile("$0 / $1").value();
+    const int32_t neg[]{7, -2};
+    assert(q(neg) == optional(7 / -2));
+    assert(q.code().end()[-2].op == opcode::div_checked);
+  }
+  {
+    auto p = program::compile("$0 * 3 + $1 - 5 / $0").value();
+    const int32_t args[]{4, 7};
+    assert(p(args) == optional(((4 * 3 + 7) - 5) / 4));
+    const int32_t zero[]{0, 7};
+    assert(p(zero) == nullopt);
+    assert(p(span(args, 1)) == nullopt); // 引数が足りない
+  }
+  {
+    auto div0 = program::compile("$0 / 0").value();
+    auto neg = program::compile("$0 / -1").value();
+    const int32_t min[]{numeric_limits<int32_t>::min()}, one[]{1};
+    assert(div0(one) == nullopt);
+    assert(neg(one) == optional(-1));
+    assert(neg(min) == nullopt);
+    assert(neg.code().end()[-2].op == opcode::neg);
+  }
+  assert(program::compile("98 / 12").value()({}) == optional(98 / 12));
+  assert(not program::compile(""));
+  assert(not program::compile("1 +"));
+  assert(not program::compile("1 % 2"));
+  assert(not program::compile("$x + 1"));
+  assert(not program::compile("$99 + 1"));
+
+  // 繰り返し評価の計測: 同じテンプレートを異なる被演算子で評価する
+  constexpr size_t n = 1'000'000;
+  const string_view ops = "+-*/";
+  vector<array<int32_t, 2>> args(n);
+  vector<string> lines(n);
+  for (size_t i = 0; i < n; ++i) {
+    args[i] = {static_cast<int32_t>(i % 10007),
+               static_cast<int32_t>(i % 97 + 1)};
+    lines[i] = to_string(args[i][0]) + ' ' + ops[i % 4] + ' '
+               + to_string(args[i][1]);
+  }
+  vector<program> programs;
+  for (char op : ops)
+    programs.push_back(program::compile(string("$0 ") + op + " $1").value());
+
+  using clock = chrono::steady_clock;
+  auto evals_per_sec = [&](auto f) {
+    int64_t sum = 0;
+    const auto t0 = clock::now();
+    for (size_t i = 0; i < n; ++i)
+      sum += f(i).value_or(0);
+    const double rate =
+      n / chrono::duration<double>(clock::now() - t0).count();
+    return pair(rate, sum);
+  };
+  const auto [r_expr, s_expr] =
+    evals_per_sec([&](size_t i) { return parse_expr(lines[i]); });
+  const auto [r_view, s_view] =
+    evals_per_sec([&](size_t i) { return parse_expr_view(lines[i]); });
+  const auto [r_vm, s_vm] =
+    evals_per_sec([&](size_t i) { return programs[i % 4](args[i]); });
+  assert(s_expr == s_vm and s_view == s_vm);
+  cout << "parse_expr:      " << r_expr << " evals/s\n"
+       << "parse_expr_view: " << r_view << " evals/s\n"
+       << "vm ("
+       << (NS_VM_THREADED ? "computed goto" : "switch") << "): " << r_vm
+       << " evals/s" << endl;
+}
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+// for main
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std; // 見やすさのため
+
+namespace ns {
+  namespace __swar {
+    // 8 バイトがすべて '0'..'9' であるか
+    constexpr bool is_eight_digits(uint64_t v) noexcept {
+      return ((v & 0xF0F0F0F0F0F0F0F0)
+              | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+             == 0x3333333333333333;
+    }
+
+    // リトルエンディアンで読み込んだ 8 桁の数字を数値に変換する
+    // 隣り合う桁を 2 桁、4 桁、8 桁と乗算加算で畳み込む
+    constexpr uint32_t parse_eight_digits(uint64_t v) noexcept {
+      constexpr uint64_t mask = 0x000000FF000000FF;
+      constexpr uint64_t mul1 = 100 + (1000000ULL << 32);
+      constexpr uint64_t mul2 = 1 + (10000ULL << 32);
+      v -= 0x3030303030303030;
+      v = v * 10 + (v >> 8);
+      v = ((v & mask) * mul1 + ((v >> 16) & mask) * mul2) >> 32;
+      return static_cast<uint32_t>(v);
+    }
+
+    // 16 桁の数値はこれ未満であり、数字以外を含むことを表すのに用いる
+    inline constexpr uint64_t not_digits = ~uint64_t{0};
+
+    // [p, end) の 1 ~ 16 桁の数字の列を変換する。数字以外を含む場合は not_digits を返す
+    // [first, end) は 8 バイト以上の読み込み可能な範囲であり、[first, p) は窓の読み込みにのみ用いる
+    //
+    // 末尾の 16 バイトを 128 bit の窓として読み、p より手前を '0' で置き換えてから 8 桁ずつ変換する。
+    // 桁数に依存する部分はシフトとマスクで扱い、桁ごとのループも分岐も持たない
+    [[gnu::always_inline]] inline uint64_t
+    parse_sixteen_digits(const char* first, const char* p, const char* end) noexcept {
+      using u128 = unsigned __int128;
+      constexpr uint64_t zeros = 0x3030303030303030;
+      // 窓の前半 [end - 16, end - 8) は、読み込み可能な範囲の先頭で切り詰めて読み、
+      // 切り詰めた d バイトだけずらす。ずらして空いた位置は p より手前なので、下で置き換わる
+      const auto d = max<ptrdiff_t>(16 - (end - first), 0);
+      uint64_t head, tail;
+      memcpy(&head, end - 16 + d, sizeof(head));
+      memcpy(&tail, end - 8, sizeof(tail));
+      head <<= 4 * d; // d == 8 でも未定義にならないよう 2 回に分ける
+      head <<= 4 * d;
+      // リトルエンディアンでは、p より手前の (16 - 桁数) バイトは窓の下位にある
+      const u128 mask = (u128{1} << (8 * (16 - (end - p)))) - 1;
+      u128 w = static_cast<u128>(tail) << 64 | head;
+      w = (w & ~mask) | ((static_cast<u128>(zeros) << 64 | zeros) & mask);
+      const auto hi = static_cast<uint64_t>(w), lo = static_cast<uint64_t>(w >> 64);
+      // 判定も分岐せずに選択する
+      const uint64_t n = uint64_t{parse_eight_digits(hi)} * 100000000 + parse_eight_digits(lo);
+      return is_eight_digits(hi) & is_eight_digits(lo) ? n : not_digits;
+    }
+
+    // 17 桁以上の場合。呼び出し側を小さく保つため、インライン展開しない
+    [[gnu::noinline]] inline optional<uint64_t>
+    parse_long_magnitude(const char* first, const char* p, const char* end) noexcept {
+      // 20 桁を超える場合のみ、先頭の 0 を読み飛ばす
+      // 0 を除いて 20 桁を超える場合は、数字であっても範囲外
+      if (end - p > numeric_limits<uint64_t>::digits10 + 1) {
+        while (p != end and *p == '0')
+          ++p;
+        if (end - p <= 16) {
+          const uint64_t n = p == end ? 0 : parse_sixteen_digits(first, p, end);
+          return n != not_digits ? optional(n) : nullopt;
+        }
+        if (end - p > numeric_limits<uint64_t>::digits10 + 1)
+          return nullopt;
+      }
+      // 上位 9 ~ 12 桁と下位 8 桁に分ける。上位の窓の手前にも 8 バイト以上ある
+      uint64_t chunk;
+      memcpy(&chunk, end - 8, sizeof(chunk));
+      const uint64_t hi = parse_sixteen_digits(first, p, end - 8);
+      uint64_t n;
+      if (hi == not_digits or not is_eight_digits(chunk)
+          or __builtin_mul_overflow(hi, 100000000, &n)
+          or __builtin_add_overflow(n, parse_eight_digits(chunk), &n))
+        return nullopt;
+      return n;
+    }
+
+    // 8 バイト以上の文字列に対する parse_int
+    // 短い文字列の経路にレジスタの退避が加わらないよう、インライン展開しない
+    template <class Int>
+    [[gnu::noinline]] optional<Int> parse_int(string_view sv) noexcept {
+      using U = make_unsigned_t<Int>;
+      const char* p = sv.data();
+      const char* const end = p + sv.size();
+      bool neg = false;
+      if constexpr (is_signed_v<Int>) {
+        if (*p == '-') {
+          neg = true;
+          ++p;
+        }
+      }
+      uint64_t m;
+      if (end - p <= 16) [[likely]] {
+        m = parse_sixteen_digits(sv.data(), p, end);
+        if (m == not_digits)
+          return nullopt;
+      } else if (const auto r = parse_long_magnitude(sv.data(), p, end)) {
+        m = *r;
+      } else {
+        return nullopt;
+      }
+      // 負数の絶対値の上限は max + 1
+      const uint64_t limit =
+        static_cast<uint64_t>(numeric_limits<Int>::max()) + neg;
+      if (m > limit)
+        return nullopt;
+      const U u = static_cast<U>(m);
+      return static_cast<Int>(neg ? static_cast<U>(U{0} - u) : u);
+    }
+  } // namespace __swar
+
+  /// from_chars(first, last, n) が ec == errc{} かつ ptr == last となる場合に限り
+  /// n を返す。すなわち、先頭の '-' (符号付きの場合のみ) と 10 進数字のみから成り、
+  /// Int の範囲に収まる文字列を受け付ける
+  template <integral Int>
+  requires (not same_as<Int, bool>)
+  optional<Int> parse_int(string_view sv) noexcept {
+    // 8 バイト未満 (高々 7 桁) の場合と、ビッグエンディアンの場合は from_chars に任せる
+    if (endian::native == endian::little and sv.size() >= 8)
+      return __swar::parse_int<Int>(sv);
+    Int n;
+    const auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+    if (ec == errc{} and ptr == sv.data() + sv.size())
+      return n;
+    else
+      return nullopt;
+  }
+} // namespace ns
+
+// from_chars による実装。定数評価で用いるほか、差分テストと計測の基準とする
+template <integral Int>
+constexpr auto parse_from_chars(string_view sv) -> optional<Int> {
+  Int n{};
+  auto [ptr, ec] = from_chars(sv.data(), sv.data() + sv.size(), n);
+  if (ec == errc{} and ptr == sv.data() + sv.size())
+    return n;
+  else
+    return nullopt;
+}
+
+// 実行時には ns::parse_int を用いる
+template <integral Int>
+constexpr auto parse(string_view sv) -> optional<Int> {
+  if consteval {
+    return parse_from_chars<Int>(sv);
+  } else {
+    return ns::parse_int<Int>(sv);
+  }
+}
+
+template <class Int>
+void differential_test(mt19937_64& gen, const vector<string>& corpus) {
+  for (const auto& s : corpus)
+    assert(parse<Int>(s) == parse_from_chars<Int>(s));
+  // ランダムな文字列 (数字が多めになるよう偏らせる)
+  constexpr string_view alphabet = "0123456789012345678900-+ x/:";
+  uniform_int_distribution<size_t> len(0, 26), ch(0, alphabet.size() - 1);
+  string s;
+  for (int i = 0; i < 200'000; ++i) {
+    s.resize(len(gen));
+    for (auto& c : s)
+      c = alphabet[ch(gen)];
+    assert(parse<Int>(s) == parse_from_chars<Int>(s));
+  }
+  // 境界付近の値と、それに先頭の 0 を付けたもの
+  for (Int base :
+       {numeric_limits<Int>::min(), numeric_limits<Int>::max(), Int{0}})
+    for (int d = -3; d <= 3; ++d) {
+      // 溢れた場合は折り返す
+      const auto v =
+        static_cast<Int>(static_cast<make_unsigned_t<Int>>(base) + d);
+      for (const auto& t : {to_string(v), "000000000" + to_string(v)}) {
+        assert(parse<Int>(t) == parse_from_chars<Int>(t));
+        assert(parse<Int>(t + "0") == parse_from_chars<Int>(t + "0"));
+        assert(parse<Int>(t + "9") == parse_from_chars<Int>(t + "9"));
+      }
+    }
+}
+
+int main() {
+  static_assert(parse<int32_t>("-2147483648") == numeric_limits<int32_t>::min());
+
+  const vector<string> corpus{
+    "", "-", "+1", " 1", "1 ", "0", "-0", "00", "-00000000000000000000001",
+    "12345678", "123456789", "1234567812345678", "12345678123456789",
+    "99999999999999999999", "18446744073709551615", "18446744073709551616",
+    "9223372036854775807", "9223372036854775808", "-9223372036854775808",
+    "-9223372036854775809", "4294967295", "4294967296", "2147483647",
+    "2147483648", "-2147483648", "-2147483649", "1234567a", "12345678a",
+    "a2345678", "12:45678", "12/45678", "1234567812345678/",
+  };
+  mt19937_64 gen(42);
+  differential_test<int8_t>(gen, corpus);
+  differential_test<uint8_t>(gen, corpus);
+  differential_test<int16_t>(gen, corpus);
+  differential_test<int32_t>(gen, corpus);
+  differential_test<uint32_t>(gen, corpus);
+  differential_test<int64_t>(gen, corpus);
+  differential_test<uint64_t>(gen, corpus);
+
+  // 計測: 桁数の範囲ごとのランダムな数値
+  // n 桁の上限 10^n - 1 は、int64_t に収まるよう最大値で切り詰める
+  uint64_t pow10[20]{1};
+  for (int i = 1; i < 20; ++i)
+    pow10[i] = pow10[i - 1] * 10;
+  using parser_t = optional<int64_t> (*)(string_view);
+  const parser_t parsers[]{parse_from_chars<int64_t>, parse<int64_t>};
+  cout << "digits\tfrom_chars [ns/number]\tparse [ns/number]\n";
+  for (const auto& [lo, hi] : {pair(1, 7), pair(8, 16), pair(17, 19), pair(1, 19)}) {
+    vector<string> inputs(1'000'000);
+    uniform_int_distribution<int> digits(lo, hi);
+    for (auto& s : inputs) {
+      const int n = digits(gen);
+      const auto max = min<uint64_t>(pow10[n] - 1, numeric_limits<int64_t>::max());
+      s = to_string(uniform_int_distribution<int64_t>(0, static_cast<int64_t>(max))(gen));
+    }
+    double times[size(parsers)];
+    uint64_t sums[size(parsers)]{};
+    for (size_t k = 0; k < size(parsers); ++k) {
+      times[k] = 1e300;
+      for (int rep = 0; rep < 5; ++rep) {
+        const auto t0 = chrono::steady_clock::now();
+        for (const auto& s : inputs)
+          sums[k] += parsers[k](s).value_or(0);
+        const chrono::duration<double, nano> dt = chrono::steady_clock::now() - t0;
+        times[k] = std::min(times[k], dt.count() / inputs.size());
+      }
+    }
+    assert(sums[0] == sums[1]);
+    cout << lo << '-' << hi << '\t' << times[0] << '\t' << times[1] << '\n';
+  }
+}
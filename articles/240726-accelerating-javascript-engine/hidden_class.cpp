@@ -0,0 +1,270 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+// for main
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+// 240726-accelerating-javascript-engine.md の Hidden Class と Inline Caching を用いた、
+// フィールドが実行時に定まるレコード
+//
+// 同じ順序でフィールドを追加したレコードは同じ shape (Hidden Class) を共有する。
+// shape はフィールド名からスロット番号への対応を持ち、レコード自体は値をスロットの配列に格納する。
+// 呼び出し箇所ごとに置く inline_cache は (shape, スロット番号) の組を記憶し、
+// shape が一致する限りフィールド名のハッシュ計算と比較を行わずに値を取得する
+namespace ns {
+  using value = std::variant<std::monostate, bool, std::int64_t, double, std::string>;
+
+  // std::string をキーとする unordered_map を std::string_view で検索するためのハッシュ
+  struct __string_hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const noexcept {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+
+  /// レコードのレイアウト (フィールド名からスロット番号への対応)
+  /// shape は空の shape を根とする遷移木をなし、フィールドを 1 つ追加するごとに子の shape へ遷移する。
+  /// 一度作られた shape は破棄されず、アドレスによって同一性を判定できる
+  /// 遷移木の変更は同期されないため、複数のスレッドから同時にフィールドを追加してはならない
+  class shape {
+    //! フィールド名からスロット番号への対応 (祖先のフィールドを含む)
+    std::unordered_map<std::string, std::size_t, __string_hash, std::equal_to<>> slots_;
+    //! スロット番号順のフィールド名
+    std::vector<std::string> keys_;
+    //! フィールドを 1 つ追加した shape への遷移
+    mutable std::unordered_map<std::string, std::unique_ptr<shape>, __string_hash, std::equal_to<>>
+      transitions_;
+
+    shape() = default;
+
+  public:
+    shape(const shape&) = delete;
+    shape& operator=(const shape&) = delete;
+
+    /// フィールドを持たない shape
+    static const shape* empty() {
+      static const shape root;
+      return &root;
+    }
+
+    std::size_t size() const noexcept { return keys_.size(); }
+    const std::vector<std::string>& keys() const noexcept { return keys_; }
+
+    std::optional<std::size_t> find(std::string_view key) const {
+      if (auto it = slots_.find(key); it != slots_.end())
+        return it->second;
+      return std::nullopt;
+    }
+
+    /// フィールド key を末尾に追加した shape
+    /// 同じ shape から同じフィールドを追加した場合は、常に同じ shape を返す
+    const shape* with(std::string_view key) const {
+      if (auto it = transitions_.find(key); it != transitions_.end())
+        return it->second.get();
+      std::unique_ptr<shape> next(new shape);
+      next->slots_ = slots_;
+      next->keys_ = keys_;
+      next->slots_.emplace(key, keys_.size());
+      next->keys_.emplace_back(key);
+      return transitions_.emplace(key, std::move(next)).first->second.get();
+    }
+  };
+
+  /// フィールドへのアクセスを行う箇所ごとに置くキャッシュ
+  /// 直近に出会った N 個の shape について、その shape でのスロット番号を記憶する (多相 inline cache)
+  template <std::size_t N = 4>
+  struct inline_cache {
+    struct entry {
+      //! アクセス前のレコードの shape
+      const shape* from = nullptr;
+      //! アクセス後のレコードの shape (フィールドを追加した場合のみ from と異なる)
+      const shape* to = nullptr;
+      std::size_t slot = 0;
+    };
+
+    std::string key;
+    std::array<entry, N> entries{};
+    //! 次にミスしたときに置き換えるエントリ
+    std::size_t next = 0;
+
+    explicit inline_cache(std::string key) : key(std::move(key)) {}
+
+    void insert(const shape* from, const shape* to, std::size_t slot) {
+      entries[next] = {from, to, slot};
+      next = (next + 1) % N;
+    }
+  };
+
+  /// 実行時に定まるフィールドを持つレコード
+  class record {
+    const shape* shape_ = shape::empty();
+    std::vector<value> slots_;
+
+  public:
+    record() = default;
+
+    const shape* current_shape() const noexcept { return shape_; }
+    std::size_t size() const noexcept { return slots_.size(); }
+
+    /// フィールド key の値。存在しない場合は nullptr
+    value* find(std::string_view key) {
+      const auto slot = shape_->find(key);
+      return slot ? &slots_[*slot] : nullptr;
+    }
+    const value* find(std::string_view key) const {
+      return const_cast<record&>(*this).find(key);
+    }
+
+    /// inline cache を用いて検索する
+    template <std::size_t N>
+    value* find(inline_cache<N>& ic) {
+      for (const auto& e : ic.entries)
+        if (e.from == shape_ and e.to == shape_)
+          return &slots_[e.slot];
+      // ミス: shape に問い合わせ、結果を記憶する
+      const auto slot = shape_->find(ic.key);
+      if (not slot)
+        return nullptr;
+      ic.insert(shape_, shape_, *slot);
+      return &slots_[*slot];
+    }
+    template <std::size_t N>
+    const value* find(inline_cache<N>& ic) const {
+      return const_cast<record&>(*this).find(ic);
+    }
+
+    /// フィールド key に v を設定する。存在しない場合は末尾に追加する
+    void set(std::string_view key, value v) {
+      if (const auto slot = shape_->find(key)) {
+        slots_[*slot] = std::move(v);
+        return;
+      }
+      shape_ = shape_->with(key);
+      slots_.push_back(std::move(v));
+    }
+
+    /// inline cache を用いて設定する
+    /// フィールドの追加も (追加前の shape, 追加後の shape) の組として記憶する
+    template <std::size_t N>
+    void set(inline_cache<N>& ic, value v) {
+      for (const auto& e : ic.entries)
+        if (e.from == shape_) {
+          if (e.to != shape_) {
+            shape_ = e.to;
+            slots_.push_back(std::move(v));
+          } else {
+            slots_[e.slot] = std::move(v);
+          }
+          return;
+        }
+      const auto from = shape_;
+      set(ic.key, std::move(v));
+      ic.insert(from, shape_, *shape_->find(ic.key));
+    }
+  };
+} // namespace ns
+
+int main() {
+  {
+    ns::record a, b, c;
+    a.set("x", std::int64_t(1));
+    a.set("y", 2.5);
+    b.set("x", std::int64_t(3));
+    b.set("y", 4.5);
+    // 同じ順序でフィールドを追加したレコードは shape を共有する
+    assert(a.current_shape() == b.current_shape());
+    assert((a.current_shape()->keys() == std::vector<std::string>{"x", "y"}));
+    // 異なる順序では別の shape になる
+    c.set("y", 0.5);
+    c.set("x", std::int64_t(5));
+    assert(c.current_shape() != a.current_shape());
+    // 既存のフィールドの上書きでは shape は変わらない
+    const auto before = a.current_shape();
+    a.set("x", std::string("one"));
+    assert(a.current_shape() == before && std::get<std::string>(*a.find("x")) == "one");
+    assert(a.find("z") == nullptr);
+
+    // 1 つの呼び出し箇所で 2 つの shape に出会う
+    ns::inline_cache<> x_ic("x");
+    std::int64_t sum = 0;
+    for (ns::record* r : {&b, &c, &b, &c})
+      sum += std::get<std::int64_t>(*r->find(x_ic));
+    assert(sum == 16);
+    assert(x_ic.entries[0].from == b.current_shape() && x_ic.entries[1].from == c.current_shape());
+    assert(x_ic.next == 2);
+
+    // フィールドの追加をキャッシュする
+    ns::inline_cache<> z_ic("z");
+    ns::record d, e;
+    d.set("x", std::int64_t(0));
+    e.set("x", std::int64_t(0));
+    d.set(z_ic, true);
+    e.set(z_ic, false); // キャッシュにヒットし、遷移をたどらずに追加する
+    assert(d.current_shape() == e.current_shape() && e.size() == 2);
+    assert(std::get<bool>(*d.find("z")) && not std::get<bool>(*e.find("z")));
+    e.set(z_ic, true); // 追加後の shape では上書きになる
+    assert(std::get<bool>(*e.find("z")) && e.size() == 2);
+  }
+
+  // 計測: テレメトリのレコードの 2 つのフィールドの合計を求める
+  const std::vector<std::string> fields{"timestamp", "host", "service", "region", "cpu_usage",
+                                        "memory_usage", "disk_usage", "status"};
+  constexpr std::size_t n = 200'000;
+  std::vector<std::unordered_map<std::string, ns::value>> maps(n);
+  std::vector<ns::record> records(n);
+  for (std::size_t i = 0; i < n; ++i)
+    for (const auto& f : fields) {
+      ns::value v = f == "host" || f == "service" || f == "region" || f == "status"
+                      ? ns::value(f + std::to_string(i % 16))
+                      : ns::value(static_cast<double>(i % 100));
+      maps[i].emplace(f, v);
+      records[i].set(f, std::move(v));
+    }
+  assert(std::ranges::all_of(records, [&](const auto& r) { return r.current_shape() == records[0].current_shape(); }));
+
+  auto best_of = [](auto f) {
+    double best = 1e300, result = 0;
+    for (int rep = 0; rep < 5; ++rep) {
+      const auto t0 = std::chrono::steady_clock::now();
+      result = f();
+      const std::chrono::duration<double, std::milli> dt = std::chrono::steady_clock::now() - t0;
+      best = std::min(best, dt.count());
+    }
+    return std::pair(best, result);
+  };
+  const auto [t_map, s_map] = best_of([&] {
+    double sum = 0;
+    for (const auto& m : maps)
+      sum += std::get<double>(m.at("cpu_usage")) + std::get<double>(m.at("memory_usage"));
+    return sum;
+  });
+  const auto [t_shape, s_shape] = best_of([&] {
+    double sum = 0;
+    for (const auto& r : records)
+      sum += std::get<double>(*r.find("cpu_usage")) + std::get<double>(*r.find("memory_usage"));
+    return sum;
+  });
+  const auto [t_ic, s_ic] = best_of([&] {
+    static ns::inline_cache<> cpu_ic("cpu_usage"), memory_ic("memory_usage");
+    double sum = 0;
+    for (const auto& r : records)
+      sum += std::get<double>(*r.find(cpu_ic)) + std::get<double>(*r.find(memory_ic));
+    return sum;
+  });
+  assert(s_map == s_shape && s_map == s_ic);
+  std::cout << "unordered_map<string, variant>: " << t_map << " ms\n"
+            << "shape lookup (no cache):        " << t_shape << " ms\n"
+            << "inline cache:                   " << t_ic << " ms" << std::endl;
+}
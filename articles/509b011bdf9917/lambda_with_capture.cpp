@@ -9,7 +9,7 @@ struct __perfect_forward_impl;
 template <class Op, std::size_t ...Idx, class ...Bound>
 struct __perfect_forward_impl<Op, std::index_sequence<Idx...>, Bound...> {
 private:
-    std::tuple<Bound...> bound_;
+    [[no_unique_address]] std::tuple<Bound...> bound_;
 
 public:
     template <class ...BoundArgs, class = std::enable_if_t<
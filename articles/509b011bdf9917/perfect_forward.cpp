@@ -10,7 +10,7 @@ struct __perfect_forward_impl;
 template <class Op, std::size_t ...Idx, class ...Bound>
 struct __perfect_forward_impl<Op, std::index_sequence<Idx...>, Bound...> {
 private:
-    std::tuple<Bound...> bound_;
+    [[no_unique_address]] std::tuple<Bound...> bound_;
 
 public:
     template <class ...BoundArgs, class = std::enable_if_t<
@@ -96,4 +96,10 @@ constexpr auto partially_applied_plus(T&& t) {
 int main() {
     constexpr auto fn = partially_applied_plus(42);
     std::cout << fn(1) << std::endl; // 43
+
+    // 状態を持たない束縛引数は領域を占めない
+    using one = std::integral_constant<int, 1>;
+    static_assert(std::is_empty_v<partially_applied_plus_t<one>>);
+    static_assert(sizeof(__perfect_forward<std::plus<>, one, int>) == sizeof(int));
+    static_assert(partially_applied_plus(one{})(41) == 42);
 }